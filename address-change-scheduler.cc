@@ -0,0 +1,181 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "ns3/ipv4.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/simulator.h"
+#include "address-change-scheduler.h"
+
+#include <fstream>
+#include <sstream>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("AddressChangeScheduler");
+
+AddressChangeScheduler::AddressChangeScheduler ()
+  : m_count (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+AddressChangeScheduler::Add (const AddressChangeEvent &event)
+{
+  NS_LOG_FUNCTION (this << event.time << event.node << event.interface << event.address);
+  m_events.push_back (event);
+  ++m_count;
+}
+
+uint32_t
+AddressChangeScheduler::Parse (const std::string &events)
+{
+  NS_LOG_FUNCTION (this << events);
+  uint32_t added = 0;
+  std::istringstream is (events);
+  std::string entry;
+  while (std::getline (is, entry, ';'))
+    {
+      added += ParseEntry (entry);
+    }
+  return added;
+}
+
+uint32_t
+AddressChangeScheduler::Load (const std::string &fileName)
+{
+  NS_LOG_FUNCTION (this << fileName);
+  std::ifstream file (fileName.c_str ());
+  if (!file)
+    {
+      NS_FATAL_ERROR ("Cannot open address change file " << fileName);
+    }
+  uint32_t added = 0;
+  std::string line;
+  while (std::getline (file, line))
+    {
+      added += ParseEntry (line);
+    }
+  return added;
+}
+
+bool
+AddressChangeScheduler::ParseEntry (const std::string &entry)
+{
+  std::string::size_type start = entry.find_first_not_of (" \t\r\n");
+  if (start == std::string::npos || entry[start] == '#')
+    {
+      return false;
+    }
+  std::istringstream is (entry.substr (start));
+  double seconds;
+  uint32_t node;
+  uint32_t interface;
+  std::string address;
+  char sep1, sep2, sep3;
+  if (!(is >> seconds >> sep1 >> node >> sep2 >> interface >> sep3 >> address)
+      || sep1 != ',' || sep2 != ',' || sep3 != ',')
+    {
+      NS_FATAL_ERROR ("Malformed address change \"" << entry
+                      << "\", expected time,node,interface,address/prefix");
+    }
+  std::string::size_type slash = address.find ('/');
+  if (slash == std::string::npos)
+    {
+      NS_FATAL_ERROR ("Address change \"" << entry << "\" lacks a prefix length");
+    }
+  if (seconds < 0)
+    {
+      NS_FATAL_ERROR ("Address change \"" << entry << "\" has a negative time");
+    }
+
+  AddressChangeEvent event;
+  event.time = Seconds (seconds);
+  event.node = node;
+  event.interface = interface;
+  event.address = Ipv4Address (address.substr (0, slash).c_str ());
+  event.mask = Ipv4Mask (address.substr (slash).c_str ());
+  Add (event);
+  return true;
+}
+
+void
+AddressChangeScheduler::SetAddressChangeCallback (AddressChangeCallback cb)
+{
+  NS_LOG_FUNCTION (this);
+  m_changeCallback = cb;
+}
+
+void
+AddressChangeScheduler::Schedule (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (std::vector<AddressChangeEvent>::const_iterator it = m_events.begin ();
+       it != m_events.end (); ++it)
+    {
+      Validate (*it);
+      Simulator::ScheduleWithContext (it->node, it->time - Simulator::Now (),
+                                      &AddressChangeScheduler::Apply, this, *it);
+    }
+  m_events.clear ();
+}
+
+void
+AddressChangeScheduler::Validate (const AddressChangeEvent &event) const
+{
+  if (event.time < Simulator::Now ())
+    {
+      NS_FATAL_ERROR ("Address change of node " << event.node << " at "
+                      << event.time.GetSeconds () << "s is in the past, now is "
+                      << Simulator::Now ().GetSeconds () << "s");
+    }
+  if (event.node >= NodeList::GetNNodes ())
+    {
+      NS_FATAL_ERROR ("Address change at " << event.time.GetSeconds () << "s names node "
+                      << event.node << ", there are " << NodeList::GetNNodes () << " nodes");
+    }
+  Ptr<Ipv4> ipv4 = NodeList::GetNode (event.node)->GetObject<Ipv4> ();
+  if (!ipv4)
+    {
+      NS_FATAL_ERROR ("Address change at " << event.time.GetSeconds () << "s names node "
+                      << event.node << ", which has no IPv4 stack");
+    }
+  if (event.interface >= ipv4->GetNInterfaces ())
+    {
+      NS_FATAL_ERROR ("Address change at " << event.time.GetSeconds () << "s names interface "
+                      << event.interface << " of node " << event.node << ", which has "
+                      << ipv4->GetNInterfaces () << " interfaces");
+    }
+  if (ipv4->GetNAddresses (event.interface) == 0)
+    {
+      NS_FATAL_ERROR ("Address change at " << event.time.GetSeconds () << "s names interface "
+                      << event.interface << " of node " << event.node
+                      << ", which has no address to replace");
+    }
+}
+
+uint32_t
+AddressChangeScheduler::GetN (void) const
+{
+  return m_count;
+}
+
+void
+AddressChangeScheduler::Apply (AddressChangeEvent event)
+{
+  NS_LOG_FUNCTION (this << event.node << event.interface << event.address);
+  Ptr<Node> node = NodeList::GetNode (event.node);
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  Ipv4Address before = ipv4->GetAddress (event.interface, 0).GetLocal ();
+  ipv4->RemoveAddress (event.interface, 0);
+  ipv4->AddAddress (event.interface, Ipv4InterfaceAddress (event.address, event.mask));
+  NS_LOG_INFO ("Node " << event.node << " interface " << event.interface
+               << " changed address from " << before << " to " << event.address);
+  if (!m_changeCallback.IsNull ())
+    {
+      m_changeCallback (node, before, event.address);
+    }
+}
+
+} // namespace ns3
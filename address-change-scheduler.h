@@ -0,0 +1,119 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef ADDRESS_CHANGE_SCHEDULER_H
+#define ADDRESS_CHANGE_SCHEDULER_H
+
+#include "ns3/callback.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+class Node;
+
+/**
+ * \brief One change of the address of a node interface.
+ */
+struct AddressChangeEvent
+{
+  Time        time;       //!< Time of the change
+  uint32_t    node;       //!< Node id
+  uint32_t    interface;  //!< Ipv4 interface index on the node
+  Ipv4Address address;    //!< New address of the interface
+  Ipv4Mask    mask;       //!< Network mask of the new address
+};
+
+/**
+ * \brief Schedules a list of address changes, each exactly once.
+ *
+ * Events are read from a string or a file with one event per entry:
+ *
+ *     time,node,interface,address/prefix
+ *
+ * e.g. "0.3,0,1,10.1.1.3/24".  In a string, entries are separated by ';';
+ * in a file, by new lines, and lines starting with '#' are ignored.
+ *
+ * At the time of an event, the first address of the interface is
+ * replaced by the new one and the address change callback is invoked,
+ * typically to reconnect the applications of the node.
+ */
+class AddressChangeScheduler
+{
+public:
+  /**
+   * Callback invoked after an address change: node, old and new address.
+   */
+  typedef Callback<void, Ptr<Node>, Ipv4Address, Ipv4Address> AddressChangeCallback;
+
+  AddressChangeScheduler ();
+
+  /**
+   * \param event the event to add
+   */
+  void Add (const AddressChangeEvent &event);
+
+  /**
+   * \brief Add the events of a string.
+   * \param events the events, separated by ';'
+   * \return the number of events added
+   */
+  uint32_t Parse (const std::string &events);
+
+  /**
+   * \brief Add the events of a file.
+   * \param fileName the file, one event per line
+   * \return the number of events added
+   */
+  uint32_t Load (const std::string &fileName);
+
+  /**
+   * \param cb the callback invoked after each address change
+   */
+  void SetAddressChangeCallback (AddressChangeCallback cb);
+
+  /**
+   * \brief Schedule all the events added so far.
+   *
+   * It is a fatal error for an event to be in the past, or to name a
+   * node or an interface that does not exist.
+   */
+  void Schedule (void);
+
+  /**
+   * \return the number of events added so far
+   */
+  uint32_t GetN (void) const;
+
+private:
+  /**
+   * \brief Add one event from its text form.
+   * \param entry the event
+   * \return false if the entry is blank or a comment
+   */
+  bool ParseEntry (const std::string &entry);
+
+  /**
+   * \brief Check that an event can be carried out, or abort.
+   * \param event the event
+   */
+  void Validate (const AddressChangeEvent &event) const;
+
+  /**
+   * \brief Carry out an address change.
+   * \param event the event
+   */
+  void Apply (AddressChangeEvent event);
+
+  std::vector<AddressChangeEvent> m_events;  //!< Events not yet scheduled
+  AddressChangeCallback m_changeCallback;    //!< Address change callback
+  uint32_t m_count;                          //!< Events added so far
+};
+
+} // namespace ns3
+
+#endif /* ADDRESS_CHANGE_SCHEDULER_H */
@@ -0,0 +1,568 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/address.h"
+#include "ns3/log.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/node.h"
+#include "ns3/socket.h"
+#include "ns3/uinteger.h"
+#include "ns3/enum.h"
+#include "ns3/string.h"
+#include "ns3/simulator.h"
+#include "ns3/packet.h"
+#include "ns3/trace-source-accessor.h"
+#include "caching-proxy-application.h"
+#include "tcp-socket-options.h"
+
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("CachingProxyApplication");
+
+TypeId
+CachingProxyApplication::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CachingProxyApplication")
+    .SetParent<Application> ()
+    .SetGroupName("Applications")
+    .AddConstructor<CachingProxyApplication> ()
+    .AddAttribute ("Local",
+                   "The Address on which to listen for clients.",
+                   AddressValue (),
+                   MakeAddressAccessor (&CachingProxyApplication::m_local),
+                   MakeAddressChecker ())
+    .AddAttribute ("Origin",
+                   "The Address of the server misses are fetched from.",
+                   AddressValue (),
+                   MakeAddressAccessor (&CachingProxyApplication::m_origin),
+                   MakeAddressChecker ())
+    .AddAttribute ("CacheSize",
+                   "The bytes the cached objects may take.",
+                   UintegerValue (16 << 20),
+                   MakeUintegerAccessor (&CachingProxyApplication::m_cacheSize),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("EvictionPolicy",
+                   "Which objects make room for a new one: the least "
+                   "recently used (Lru), the least frequently used (Lfu) "
+                   "or the largest (Size).",
+                   EnumValue (ObjectCache::LRU),
+                   MakeEnumAccessor (&CachingProxyApplication::m_policy),
+                   MakeEnumChecker (ObjectCache::LRU, "Lru",
+                                    ObjectCache::LFU, "Lfu",
+                                    ObjectCache::SIZE, "Size"))
+    .AddAttribute ("SendSize", "The amount of cached data to send each time.",
+                   UintegerValue (512),
+                   MakeUintegerAccessor (&CachingProxyApplication::m_sendSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("CongestionControl",
+                   "TypeId name of the TCP congestion control of the sockets to the clients and to the origin, "
+                   "e.g. ns3::TcpCubic. Empty for the node's default.",
+                   StringValue (""),
+                   MakeStringAccessor (&CachingProxyApplication::m_congestionControl),
+                   MakeStringChecker ())
+    .AddAttribute ("InitialCwnd",
+                   "Initial congestion window of the sockets to the clients and to the origin, in segments. "
+                   "The value zero keeps the TcpSocket default.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&CachingProxyApplication::m_initialCwnd),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("SndBufSize",
+                   "Tx buffer size of the sockets to the clients and to the origin, in bytes. "
+                   "The value zero keeps the TcpSocket default.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&CachingProxyApplication::m_sndBufSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("RcvBufSize",
+                   "Rx buffer size of the sockets to the clients and to the origin, in bytes. "
+                   "The value zero keeps the TcpSocket default.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&CachingProxyApplication::m_rcvBufSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("SegmentSize",
+                   "TCP maximum segment size of the sockets to the clients and to the origin, in bytes. "
+                   "The value zero keeps the TcpSocket default.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&CachingProxyApplication::m_segmentSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddTraceSource ("CacheAccess",
+                     "A request has been looked up in the cache: object id, "
+                     "object size and whether it was a hit",
+                     MakeTraceSourceAccessor (&CachingProxyApplication::m_accessTrace),
+                     "ns3::CachingProxyApplication::CacheAccessTracedCallback")
+  ;
+  return tid;
+}
+
+CachingProxyApplication::CachingProxyApplication ()
+{
+  NS_LOG_FUNCTION (this);
+  m_socket = 0;
+  m_requests = 0;
+  m_hits = 0;
+  m_hitBytes = 0;
+  m_missBytes = 0;
+}
+
+CachingProxyApplication::~CachingProxyApplication ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint64_t
+CachingProxyApplication::GetRequests () const
+{
+  return m_requests;
+}
+
+uint64_t
+CachingProxyApplication::GetHits () const
+{
+  return m_hits;
+}
+
+uint64_t
+CachingProxyApplication::GetHitBytes () const
+{
+  return m_hitBytes;
+}
+
+uint64_t
+CachingProxyApplication::GetMissBytes () const
+{
+  return m_missBytes;
+}
+
+double
+CachingProxyApplication::GetHitRatio () const
+{
+  return m_requests > 0 ? static_cast<double> (m_hits) / m_requests : 0;
+}
+
+double
+CachingProxyApplication::GetByteHitRatio () const
+{
+  uint64_t bytes = m_hitBytes + m_missBytes;
+  return bytes > 0 ? static_cast<double> (m_hitBytes) / bytes : 0;
+}
+
+const ObjectCache &
+CachingProxyApplication::GetCache () const
+{
+  return m_cache;
+}
+
+void
+CachingProxyApplication::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_socket = 0;
+  m_flows.clear ();
+  m_origins.clear ();
+  m_payload = 0;
+  Application::DoDispose ();
+}
+
+void
+CachingProxyApplication::StartApplication (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_socket)
+    {
+      m_cache.SetPolicy (m_policy);
+      m_cache.SetCapacity (m_cacheSize);
+      m_socket = Socket::CreateSocket (GetNode (), TypeId::LookupByName ("ns3::TcpSocketFactory"));
+      // The client sockets are forks of this one
+      ConfigureTcpSocket (m_socket, m_congestionControl, m_initialCwnd,
+                          m_sndBufSize, m_rcvBufSize, m_segmentSize);
+      m_socket->Bind (m_local);
+      m_socket->Listen ();
+    }
+  if (!m_payload)
+    {
+      m_payload = Create<TcpPayloadSource> (m_sendSize);
+    }
+  m_socket->SetAcceptCallback (
+    MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+    MakeCallback (&CachingProxyApplication::HandleAccept, this));
+}
+
+void
+CachingProxyApplication::StopApplication (void)
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_flows.empty ())
+    {
+      CloseFlow (m_flows.begin ()->first);
+    }
+  if (m_socket)
+    {
+      m_socket->Close ();
+      m_socket->SetAcceptCallback (
+        MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+        MakeNullCallback<void, Ptr<Socket>, const Address &> ());
+    }
+}
+
+CachingProxyApplication::ProxyFlow *
+CachingProxyApplication::FindFlow (Ptr<Socket> socket)
+{
+  std::map<Ptr<Socket>, ProxyFlow>::iterator it = m_flows.find (socket);
+  return it == m_flows.end () ? 0 : &it->second;
+}
+
+void
+CachingProxyApplication::HandleAccept (Ptr<Socket> socket, const Address &from)
+{
+  NS_LOG_FUNCTION (this << socket << from);
+  ProxyFlow &flow = m_flows[socket];
+  flow.client = socket;
+  flow.originConnected = false;
+  flow.state = ProxyFlow::IDLE;
+  flow.remaining = 0;
+  flow.endless = false;
+  flow.cacheable = false;
+  flow.forwarded = false;
+  socket->SetRecvCallback (MakeCallback (&CachingProxyApplication::HandleRead, this));
+  socket->SetSendCallback (MakeCallback (&CachingProxyApplication::HandleSend, this));
+  socket->SetCloseCallbacks (
+    MakeCallback (&CachingProxyApplication::HandleClientClose, this),
+    MakeCallback (&CachingProxyApplication::HandleClientClose, this));
+}
+
+void
+CachingProxyApplication::HandleRead (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  ProxyFlow *flow = FindFlow (socket);
+  if (!flow)
+    {
+      return;
+    }
+  Ptr<Packet> packet;
+  while ((packet = socket->Recv ()) && packet->GetSize () > 0)
+    {
+      if (!flow->rxBuffer)
+        {
+          flow->rxBuffer = packet;
+        }
+      else
+        {
+          flow->rxBuffer->AddAtEnd (packet);
+        }
+    }
+  TcpRequestHeader request;
+  while (flow->rxBuffer && flow->rxBuffer->GetSize () >= request.GetSerializedSize ())
+    {
+      flow->rxBuffer->RemoveHeader (request);
+      NS_LOG_LOGIC ("request " << request);
+      flow->pending.push_back (request);
+    }
+  if (flow->state == ProxyFlow::IDLE && StartNextRequest (*flow))
+    {
+      Serve (*flow);
+    }
+}
+
+void
+CachingProxyApplication::HandleSend (Ptr<Socket> socket, uint32_t available)
+{
+  NS_LOG_FUNCTION (this << socket << available);
+  ProxyFlow *flow = FindFlow (socket);
+  if (flow && flow->state != ProxyFlow::IDLE)
+    {
+      Serve (*flow);
+    }
+}
+
+void
+CachingProxyApplication::HandleClientClose (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  CloseFlow (socket);
+}
+
+void
+CachingProxyApplication::HandleOriginRead (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  std::map<Ptr<Socket>, Ptr<Socket> >::iterator it = m_origins.find (socket);
+  if (it == m_origins.end ())
+    {
+      return;
+    }
+  ProxyFlow *flow = FindFlow (it->second);
+  if (flow && flow->state == ProxyFlow::MISS)
+    {
+      Serve (*flow);
+    }
+}
+
+void
+CachingProxyApplication::OriginConnected (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  std::map<Ptr<Socket>, Ptr<Socket> >::iterator it = m_origins.find (socket);
+  if (it == m_origins.end ())
+    {
+      return;
+    }
+  ProxyFlow *flow = FindFlow (it->second);
+  flow->originConnected = true;
+  if (flow->state == ProxyFlow::MISS && !flow->forwarded)
+    {
+      ForwardRequest (*flow);
+    }
+}
+
+void
+CachingProxyApplication::OriginFailed (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  std::map<Ptr<Socket>, Ptr<Socket> >::iterator it = m_origins.find (socket);
+  if (it == m_origins.end ())
+    {
+      return;
+    }
+  ProxyFlow *flow = FindFlow (it->second);
+  if (flow->state == ProxyFlow::MISS)
+    {
+      // The response cannot be completed; let the client see the failure
+      NS_LOG_INFO ("Origin failed during request " << flow->current.GetRequestId ());
+      CloseFlow (flow->client);
+      return;
+    }
+  flow->originConnected = false;
+  ReleaseOrigin (*flow);
+}
+
+void
+CachingProxyApplication::OriginClosed (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  std::map<Ptr<Socket>, Ptr<Socket> >::iterator it = m_origins.find (socket);
+  if (it == m_origins.end ())
+    {
+      return;
+    }
+  ProxyFlow *flow = FindFlow (it->second);
+  flow->originConnected = false;
+  if (flow->state == ProxyFlow::MISS)
+    {
+      // The end of the response may still sit in the rx buffer; the
+      // socket goes once it has been relayed
+      Serve (*flow);
+      return;
+    }
+  ReleaseOrigin (*flow);
+}
+
+bool
+CachingProxyApplication::StartNextRequest (ProxyFlow &flow)
+{
+  NS_LOG_FUNCTION (this << flow.client);
+  if (flow.pending.empty ())
+    {
+      return false;
+    }
+  flow.current = flow.pending.front ();
+  flow.pending.pop_front ();
+  ++m_requests;
+
+  uint32_t id = flow.current.GetObjectId ();
+  uint64_t size = flow.current.GetObjectSize ();
+  uint64_t offset = std::min (flow.current.GetOffset (), size);
+  flow.endless = (size == 0);
+  flow.remaining = size - offset;
+  flow.forwarded = false;
+  flow.cacheable = false;
+  bool named = id != 0 && size > 0;
+  if (named && m_cache.Lookup (id, size))
+    {
+      NS_LOG_INFO ("Hit for object " << id << " of " << size << " bytes");
+      ++m_hits;
+      m_accessTrace (id, size, true);
+      flow.state = ProxyFlow::HIT;
+    }
+  else
+    {
+      if (named)
+        {
+          NS_LOG_INFO ("Miss for object " << id << " of " << size << " bytes");
+          m_accessTrace (id, size, false);
+        }
+      // Only a whole object can be cached
+      flow.cacheable = named && offset == 0;
+      flow.state = ProxyFlow::MISS;
+      ForwardRequest (flow);
+    }
+  return true;
+}
+
+void
+CachingProxyApplication::ForwardRequest (ProxyFlow &flow)
+{
+  NS_LOG_FUNCTION (this << flow.client);
+  if (!flow.origin)
+    {
+      flow.origin = Socket::CreateSocket (GetNode (), TypeId::LookupByName ("ns3::TcpSocketFactory"));
+      ConfigureTcpSocket (flow.origin, m_congestionControl, m_initialCwnd,
+                          m_sndBufSize, m_rcvBufSize, m_segmentSize);
+      flow.origin->Bind ();
+      flow.origin->Connect (m_origin);
+      flow.origin->SetConnectCallback (
+        MakeCallback (&CachingProxyApplication::OriginConnected, this),
+        MakeCallback (&CachingProxyApplication::OriginFailed, this));
+      flow.origin->SetRecvCallback (
+        MakeCallback (&CachingProxyApplication::HandleOriginRead, this));
+      flow.origin->SetCloseCallbacks (
+        MakeCallback (&CachingProxyApplication::OriginClosed, this),
+        MakeCallback (&CachingProxyApplication::OriginFailed, this));
+      m_origins[flow.origin] = flow.client;
+      // OriginConnected forwards the request
+      return;
+    }
+  if (!flow.originConnected)
+    {
+      return;
+    }
+  Ptr<Packet> packet = Create<Packet> ();
+  packet->AddHeader (flow.current);
+  if (flow.origin->Send (packet) > 0)
+    {
+      flow.forwarded = true;
+    }
+}
+
+void
+CachingProxyApplication::Serve (ProxyFlow &flow)
+{
+  NS_LOG_FUNCTION (this << flow.client);
+  Ptr<Socket> client = flow.client;
+  while (flow.state != ProxyFlow::IDLE)
+    {
+      if (!flow.endless && flow.remaining == 0)
+        {
+          FinishRequest (flow);
+          StartNextRequest (flow);
+          continue;
+        }
+      uint32_t available = client->GetTxAvailable ();
+      if (available == 0)
+        { // HandleSend resumes once the client takes more
+          return;
+        }
+      uint32_t room = flow.endless ? available
+        : static_cast<uint32_t> (std::min<uint64_t> (available, flow.remaining));
+      if (flow.state == ProxyFlow::HIT)
+        {
+          int actual = client->Send (m_payload->Get (std::min (room, m_sendSize)));
+          if (actual <= 0)
+            {
+              return;
+            }
+          flow.remaining -= actual;
+          m_hitBytes += actual;
+          continue;
+        }
+      if (!flow.forwarded)
+        {
+          return;
+        }
+      // Read no more than the client can take, so that a slow client
+      // slows the origin down through TCP flow control
+      Ptr<Packet> packet = flow.origin->Recv (room, 0);
+      if (!packet || packet->GetSize () == 0)
+        {
+          if (!flow.originConnected)
+            {
+              NS_LOG_INFO ("Origin closed before the end of request "
+                           << flow.current.GetRequestId ());
+              CloseFlow (client);
+            }
+          return;
+        }
+      uint32_t size = packet->GetSize ();
+      client->Send (packet);
+      m_missBytes += size;
+      if (!flow.endless)
+        {
+          flow.remaining -= size;
+        }
+    }
+}
+
+void
+CachingProxyApplication::FinishRequest (ProxyFlow &flow)
+{
+  NS_LOG_FUNCTION (this << flow.client);
+  if (flow.cacheable)
+    {
+      m_cache.Insert (flow.current.GetObjectId (), flow.current.GetObjectSize ());
+    }
+  if (flow.state == ProxyFlow::MISS && !flow.originConnected)
+    {
+      ReleaseOrigin (flow);
+    }
+  flow.state = ProxyFlow::IDLE;
+}
+
+void
+CachingProxyApplication::ReleaseOrigin (ProxyFlow &flow)
+{
+  NS_LOG_FUNCTION (this << flow.client);
+  if (!flow.origin)
+    {
+      return;
+    }
+  flow.origin->SetConnectCallback (MakeNullCallback<void, Ptr<Socket> > (),
+                                   MakeNullCallback<void, Ptr<Socket> > ());
+  flow.origin->SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
+  flow.origin->SetCloseCallbacks (MakeNullCallback<void, Ptr<Socket> > (),
+                                  MakeNullCallback<void, Ptr<Socket> > ());
+  flow.origin->Close ();
+  m_origins.erase (flow.origin);
+  flow.origin = 0;
+  flow.originConnected = false;
+}
+
+void
+CachingProxyApplication::CloseFlow (Ptr<Socket> client)
+{
+  NS_LOG_FUNCTION (this << client);
+  ProxyFlow *flow = FindFlow (client);
+  if (!flow)
+    {
+      return;
+    }
+  ReleaseOrigin (*flow);
+  client->SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
+  client->SetSendCallback (MakeNullCallback<void, Ptr<Socket>, uint32_t> ());
+  client->SetCloseCallbacks (MakeNullCallback<void, Ptr<Socket> > (),
+                             MakeNullCallback<void, Ptr<Socket> > ());
+  client->Close ();
+  m_flows.erase (client);
+}
+
+CachingProxyApplicationHelper::CachingProxyApplicationHelper (Address local, Address origin)
+{
+  m_factory.SetTypeId (CachingProxyApplication::GetTypeId ());
+  SetAttribute ("Local", AddressValue (local));
+  SetAttribute ("Origin", AddressValue (origin));
+}
+
+void
+CachingProxyApplicationHelper::SetAttribute (std::string name, const AttributeValue &value)
+{
+  m_factory.Set (name, value);
+}
+
+ApplicationContainer
+CachingProxyApplicationHelper::Install (Ptr<Node> node) const
+{
+  Ptr<Application> app = m_factory.Create<Application> ();
+  node->AddApplication (app);
+  return ApplicationContainer (app);
+}
+
+} // namespace ns3
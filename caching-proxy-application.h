@@ -0,0 +1,267 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef CACHING_PROXY_APPLICATION_H
+#define CACHING_PROXY_APPLICATION_H
+
+#include "ns3/address.h"
+#include "ns3/application.h"
+#include "ns3/application-container.h"
+#include "ns3/node-container.h"
+#include "ns3/object-factory.h"
+#include "ns3/ptr.h"
+#include "ns3/traced-callback.h"
+
+#include <stdint.h>
+#include <deque>
+#include <map>
+#include <string>
+#include "object-cache.h"
+#include "tcp-payload-source.h"
+#include "tcp-request-header.h"
+
+namespace ns3 {
+
+class Socket;
+class Packet;
+
+/**
+ * \ingroup tcpserver
+ * \brief Caching proxy between TcpClientApplications and a
+ * TcpServerApplication.
+ *
+ * Clients connect to the proxy as they would to the server.  The proxy
+ * answers their requests in order: a request for an object held by the
+ * cache (a hit) is served locally, any other (a miss) is forwarded on a
+ * connection of its own to the Origin server and the response relayed as
+ * it arrives, reading from the origin only as fast as the client takes
+ * it.  A fully fetched object is then cached, evicting others by the
+ * EvictionPolicy to stay within CacheSize bytes.
+ *
+ * Requests with object id zero, of unknown size or resuming at an offset
+ * are relayed without being cached.  The connections to the origin are
+ * kept open across requests, so the origin should be Persistent.
+ */
+class CachingProxyApplication : public Application
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * TracedCallback signature for a request looked up in the cache.
+   *
+   * \param [in] objectId the id of the requested object
+   * \param [in] bytes the size of the object
+   * \param [in] hit true if the cache held it
+   */
+  typedef void (* CacheAccessTracedCallback) (uint32_t objectId, uint64_t bytes, bool hit);
+
+  CachingProxyApplication ();
+
+  virtual ~CachingProxyApplication ();
+
+  /**
+   * \return the requests received from clients
+   */
+  uint64_t GetRequests () const;
+  /**
+   * \return the requests served from the cache
+   */
+  uint64_t GetHits () const;
+  /**
+   * \return the bytes served from the cache, i.e. not fetched from the origin
+   */
+  uint64_t GetHitBytes () const;
+  /**
+   * \return the bytes relayed from the origin
+   */
+  uint64_t GetMissBytes () const;
+  /**
+   * \return the fraction of the requests served from the cache
+   */
+  double GetHitRatio () const;
+  /**
+   * \return the fraction of the bytes served from the cache
+   */
+  double GetByteHitRatio () const;
+  /**
+   * \return the cache
+   */
+  const ObjectCache &GetCache () const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  // inherited from Application base class.
+  virtual void StartApplication (void);    // Called at time specified by Start
+  virtual void StopApplication (void);     // Called at time specified by Stop
+
+  /// A client connection and its connection to the origin
+  struct ProxyFlow
+  {
+    /// What the flow is doing
+    enum State
+    {
+      IDLE, //!< No request to answer
+      HIT,  //!< Serving the current request from the cache
+      MISS  //!< Relaying the current request from the origin
+    };
+
+    Ptr<Socket>   client;          //!< Accepted client socket
+    Ptr<Socket>   origin;          //!< Socket to the origin, 0 if none
+    bool          originConnected; //!< True while the origin socket is connected
+    Ptr<Packet>   rxBuffer;        //!< Request bytes not yet parsed
+    std::deque<TcpRequestHeader> pending; //!< Requests not yet answered
+    State         state;           //!< Current state
+    TcpRequestHeader current;      //!< Request being answered
+    uint64_t      remaining;       //!< Bytes of it still to send
+    bool          endless;         //!< True if its size is unknown
+    bool          cacheable;       //!< True to cache it once fetched
+    bool          forwarded;       //!< True once sent to the origin
+  };
+
+  /**
+   * \param socket a client socket
+   * \return its flow, or 0 if unknown
+   */
+  ProxyFlow *FindFlow (Ptr<Socket> socket);
+  /**
+   * \brief Accept a client connection.
+   * \param socket the accepted socket
+   * \param from the address of the client
+   */
+  void HandleAccept (Ptr<Socket> socket, const Address &from);
+  /**
+   * \brief Read and queue the requests of a client.
+   * \param socket the client socket
+   */
+  void HandleRead (Ptr<Socket> socket);
+  /**
+   * \brief Send more to a client once its tx buffer has room.
+   * \param socket the client socket
+   * \param available the free space of the tx buffer
+   */
+  void HandleSend (Ptr<Socket> socket, uint32_t available);
+  /**
+   * \brief The client closed its connection.
+   * \param socket the client socket
+   */
+  void HandleClientClose (Ptr<Socket> socket);
+  /**
+   * \brief Relay what the origin sent.
+   * \param socket the origin socket
+   */
+  void HandleOriginRead (Ptr<Socket> socket);
+  /**
+   * \brief Forward the current request once the origin is connected.
+   * \param socket the origin socket
+   */
+  void OriginConnected (Ptr<Socket> socket);
+  /**
+   * \brief The origin could not be reached or reset the connection.
+   * \param socket the origin socket
+   */
+  void OriginFailed (Ptr<Socket> socket);
+  /**
+   * \brief The origin closed the connection.
+   * \param socket the origin socket
+   */
+  void OriginClosed (Ptr<Socket> socket);
+
+  /**
+   * \brief Look the next queued request up and start answering it.
+   * \param flow the flow
+   * \return false if no request is queued
+   */
+  bool StartNextRequest (ProxyFlow &flow);
+  /**
+   * \brief Send the request being answered to the origin, connecting to
+   * it first if needed.
+   * \param flow the flow
+   */
+  void ForwardRequest (ProxyFlow &flow);
+  /**
+   * \brief Send the client as much of the current response as it takes.
+   * \param flow the flow
+   */
+  void Serve (ProxyFlow &flow);
+  /**
+   * \brief Cache a fetched object and leave the flow idle.
+   * \param flow the flow
+   */
+  void FinishRequest (ProxyFlow &flow);
+  /**
+   * \brief Drop the origin connection of a flow.
+   * \param flow the flow
+   */
+  void ReleaseOrigin (ProxyFlow &flow);
+  /**
+   * \brief Close both connections of a flow and forget it.
+   * \param client the client socket
+   */
+  void CloseFlow (Ptr<Socket> client);
+
+  Ptr<Socket>     m_socket;       //!< Listening socket
+  Address         m_local;        //!< Local address to bind to
+  Address         m_origin;       //!< Address of the origin server
+  uint32_t        m_sendSize;     //!< Size of the writes of cached objects
+  std::string     m_congestionControl; //!< Congestion control of the sockets, empty for the default
+  uint32_t        m_initialCwnd;  //!< Initial cwnd of the sockets in segments, 0 for the default
+  uint32_t        m_sndBufSize;   //!< Tx buffer size of the sockets, 0 for the default
+  uint32_t        m_rcvBufSize;   //!< Rx buffer size of the sockets, 0 for the default
+  uint32_t        m_segmentSize;  //!< Segment size of the sockets, 0 for the default
+  uint64_t        m_cacheSize;    //!< Cache capacity in bytes
+  ObjectCache::Policy m_policy;   //!< Eviction policy
+  ObjectCache     m_cache;        //!< Cached objects
+  Ptr<TcpPayloadSource> m_payload; //!< Payload of the cached objects
+  std::map<Ptr<Socket>, ProxyFlow> m_flows;         //!< Flows by client socket
+  std::map<Ptr<Socket>, Ptr<Socket> > m_origins;    //!< Client socket by origin socket
+  uint64_t        m_requests;     //!< Requests received
+  uint64_t        m_hits;         //!< Requests served from the cache
+  uint64_t        m_hitBytes;     //!< Bytes served from the cache
+  uint64_t        m_missBytes;    //!< Bytes relayed from the origin
+
+  /// Traced Callback: a request has been looked up in the cache.
+  TracedCallback<uint32_t, uint64_t, bool> m_accessTrace;
+};
+
+class CachingProxyApplicationHelper
+{
+public:
+  /**
+   * Create a CachingProxyApplicationHelper to make it easier to work with
+   * CachingProxyApplications
+   *
+   * \param local the address the proxy listens on
+   * \param origin the address of the server it fetches misses from
+   */
+  CachingProxyApplicationHelper (Address local, Address origin);
+
+  /**
+   * Helper function used to set the underlying application attributes.
+   *
+   * \param name the name of the application attribute to set
+   * \param value the value of the application attribute to set
+   */
+  void SetAttribute (std::string name, const AttributeValue &value);
+
+  /**
+   * Install an ns3::CachingProxyApplication on the node configured with all
+   * the attributes set with SetAttribute.
+   *
+   * \param node The node on which a CachingProxyApplication will be installed.
+   * \returns Container of Ptr to the applications installed.
+   */
+  ApplicationContainer Install (Ptr<Node> node) const;
+
+private:
+  ObjectFactory m_factory; //!< Object factory.
+};
+
+} // namespace ns3
+
+#endif /* CACHING_PROXY_APPLICATION_H */
@@ -0,0 +1,287 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "ns3/string.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/ipv4-global-routing-helper.h"
+#include "client-server-topology.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ClientServerTopology");
+
+ClientServerTopology::ClientServerTopology ()
+  : m_type (STAR),
+    m_clientCount (2),
+    m_serverCount (1),
+    m_fanOut (16),
+    m_poolSize (1),
+    m_accessRate ("1Mbps"),
+    m_accessDelay ("5ms"),
+    m_bottleneckRate ("1Mbps"),
+    m_bottleneckDelay ("5ms"),
+    m_systemCount (1),
+    m_nextSubnet (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+ClientServerTopology::Type
+ClientServerTopology::ParseType (const std::string &name)
+{
+  if (name == "star")
+    {
+      return STAR;
+    }
+  if (name == "dumbbell")
+    {
+      return DUMBBELL;
+    }
+  if (name == "multitier")
+    {
+      return MULTI_TIER;
+    }
+  NS_FATAL_ERROR ("Unknown topology " << name << ", use star, dumbbell or multitier");
+  return STAR;
+}
+
+void
+ClientServerTopology::SetType (Type type)
+{
+  m_type = type;
+}
+
+void
+ClientServerTopology::SetClientCount (uint32_t count)
+{
+  m_clientCount = count;
+}
+
+void
+ClientServerTopology::SetServerCount (uint32_t count)
+{
+  NS_ABORT_MSG_IF (count == 0, "At least one server is needed");
+  m_serverCount = count;
+}
+
+void
+ClientServerTopology::SetFanOut (uint32_t fanOut)
+{
+  NS_ABORT_MSG_IF (fanOut == 0, "FanOut must be positive");
+  m_fanOut = fanOut;
+}
+
+void
+ClientServerTopology::SetAddressPoolSize (uint32_t size)
+{
+  NS_ABORT_MSG_IF (size > 252, "A /24 client subnet has at most 252 spare hosts");
+  m_poolSize = size;
+}
+
+void
+ClientServerTopology::SetAccessLink (const std::string &rate, const std::string &delay)
+{
+  m_accessRate = rate;
+  m_accessDelay = delay;
+}
+
+void
+ClientServerTopology::SetBottleneckLink (const std::string &rate, const std::string &delay)
+{
+  m_bottleneckRate = rate;
+  m_bottleneckDelay = delay;
+}
+
+void
+ClientServerTopology::SetSystemCount (uint32_t count)
+{
+  NS_ABORT_MSG_IF (count == 0, "At least one rank is needed");
+  m_systemCount = count;
+}
+
+uint32_t
+ClientServerTopology::GetClientSystemId (uint32_t i) const
+{
+  if (m_type == MULTI_TIER)
+    {
+      return GetAccessRouterSystemId (i / m_fanOut);
+    }
+  return i % m_systemCount;
+}
+
+uint32_t
+ClientServerTopology::GetAccessRouterSystemId (uint32_t i) const
+{
+  // Rank 0 has the core router and the servers already
+  return m_systemCount > 1 ? 1 + i % (m_systemCount - 1) : 0;
+}
+
+Ipv4Address
+ClientServerTopology::Link (Ptr<Node> a, Ptr<Node> b, bool access)
+{
+  PointToPointHelper pointToPoint;
+  pointToPoint.SetDeviceAttribute ("DataRate", StringValue (access ? m_accessRate : m_bottleneckRate));
+  pointToPoint.SetChannelAttribute ("Delay", StringValue (access ? m_accessDelay : m_bottleneckDelay));
+  NetDeviceContainer devices = pointToPoint.Install (a, b);
+
+  // Subnet n is 10.1.1.0 + n * 256
+  NS_ABORT_MSG_IF (m_nextSubnet >= (1u << 16) - 257, "Out of 10.0.0.0/8 subnets");
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase (Ipv4Address (Ipv4Address ("10.1.1.0").Get () + (m_nextSubnet << 8)),
+                "255.255.255.0");
+  ++m_nextSubnet;
+  Ipv4InterfaceContainer interfaces = ipv4.Assign (devices);
+  if (access)
+    {
+      m_clientInterfaces.push_back (interfaces.Get (0).second);
+    }
+  return interfaces.GetAddress (0);
+}
+
+void
+ClientServerTopology::Build (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  // Clients first, so that with the defaults the node ids are those of
+  // the original four-node scenario (n0, n1 clients, n2 router, n3 server).
+  for (uint32_t i = 0; i < m_clientCount; i++)
+    {
+      m_clients.Add (CreateObject<Node> (GetClientSystemId (i)));
+    }
+  uint32_t accessRouters = 0;
+  m_routers.Add (CreateObject<Node> (0));
+  switch (m_type)
+    {
+    case STAR:
+      break;
+    case DUMBBELL:
+      m_routers.Add (CreateObject<Node> (m_systemCount > 1 ? 1 : 0));
+      break;
+    case MULTI_TIER:
+      accessRouters = (m_clientCount + m_fanOut - 1) / m_fanOut;
+      for (uint32_t i = 0; i < accessRouters; i++)
+        {
+          m_routers.Add (CreateObject<Node> (GetAccessRouterSystemId (i)));
+        }
+      break;
+    }
+  m_servers.Create (m_serverCount, 0);
+
+  InternetStackHelper internet;
+  internet.Install (m_clients);
+  internet.Install (m_routers);
+  internet.Install (m_servers);
+
+  // Router 0 is where the servers hang off
+  Ptr<Node> serverRouter = m_routers.Get (0);
+
+  NS_LOG_INFO ("Link " << m_clientCount << " clients.");
+  for (uint32_t i = 0; i < m_clientCount; i++)
+    {
+      Ptr<Node> router;
+      switch (m_type)
+        {
+        case STAR:
+          router = m_routers.Get (0);
+          break;
+        case DUMBBELL:
+          router = m_routers.Get (1);
+          break;
+        case MULTI_TIER:
+          router = m_routers.Get (1 + i / m_fanOut);
+          break;
+        }
+      Ipv4Address home = Link (m_clients.Get (i), router, true);
+      m_clientAddresses.push_back (home);
+      std::vector<Ipv4Address> pool;
+      for (uint32_t k = 0; k < m_poolSize; k++)
+        { // hosts .1 and .2 are the client and its router
+          pool.push_back (Ipv4Address (home.Get () + 2 + k));
+        }
+      m_pools.push_back (pool);
+    }
+
+  NS_LOG_INFO ("Link " << m_serverCount << " servers.");
+  for (uint32_t i = 0; i < m_serverCount; i++)
+    {
+      m_serverAddresses.push_back (Link (m_servers.Get (i), serverRouter, false));
+    }
+
+  NS_LOG_INFO ("Link routers.");
+  if (m_type == DUMBBELL)
+    {
+      Link (m_routers.Get (1), serverRouter, false);
+    }
+  for (uint32_t i = 0; i < accessRouters; i++)
+    {
+      Link (m_routers.Get (1 + i), serverRouter, false);
+    }
+
+  // Initialize routing database and set up the routing tables in the nodes.
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+}
+
+NodeContainer
+ClientServerTopology::GetClients (void) const
+{
+  return m_clients;
+}
+
+NodeContainer
+ClientServerTopology::GetServers (void) const
+{
+  return m_servers;
+}
+
+NodeContainer
+ClientServerTopology::GetRouters (void) const
+{
+  return m_routers;
+}
+
+Ipv4Address
+ClientServerTopology::GetClientAddress (uint32_t i) const
+{
+  return m_clientAddresses.at (i);
+}
+
+uint32_t
+ClientServerTopology::GetClientInterface (uint32_t i) const
+{
+  return m_clientInterfaces.at (i);
+}
+
+Ipv4Mask
+ClientServerTopology::GetClientMask (void) const
+{
+  return Ipv4Mask ("255.255.255.0");
+}
+
+const std::vector<Ipv4Address> &
+ClientServerTopology::GetAddressPool (uint32_t i) const
+{
+  return m_pools.at (i);
+}
+
+Ipv4Address
+ClientServerTopology::GetServerAddress (uint32_t i) const
+{
+  return m_serverAddresses.at (i);
+}
+
+Ptr<Node>
+ClientServerTopology::GetEdgeRouter (void) const
+{
+  return m_routers.Get (m_type == DUMBBELL ? 1 : 0);
+}
+
+Ipv4Address
+ClientServerTopology::GetEdgeRouterAddress (void) const
+{
+  // Interface 0 is the loopback
+  return GetEdgeRouter ()->GetObject<Ipv4> ()->GetAddress (1, 0).GetLocal ();
+}
+
+} // namespace ns3
@@ -0,0 +1,167 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef CLIENT_SERVER_TOPOLOGY_H
+#define CLIENT_SERVER_TOPOLOGY_H
+
+#include "ns3/ipv4-address.h"
+#include "ns3/node-container.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief Builds point-to-point topologies of N clients and M servers.
+ *
+ * - STAR: every client and server hangs off a single router.
+ * - DUMBBELL: clients hang off a left router, servers off a right
+ *   router, and the two routers share the bottleneck link.
+ * - MULTI_TIER: clients hang off access routers, FanOut clients each;
+ *   the access routers and the servers hang off a core router.
+ *
+ * Client i gets its own /24, allocated in order from 10.1.1.0 (10.1.1.0,
+ * 10.1.2.0, ... 10.1.255.0, 10.2.0.0, ...), as host .1 with its router at
+ * .2; router and server links take the next subnets.  The address pool
+ * of client i holds the spare hosts .3, .4, ... of its subnet, so moving
+ * a client inside its pool needs no routing update.
+ *
+ * Nodes are created clients first, then routers, then servers.
+ * Client-side links use the access rate and delay, all the others the
+ * bottleneck rate and delay.
+ *
+ * For a distributed simulation over SetSystemCount () ranks, the nodes
+ * are given system ids so that the servers and their router stay on rank
+ * 0 and the clients are spread over the ranks: client by client in STAR
+ * and DUMBBELL, access router by access router (with their clients) over
+ * ranks 1 and up in MULTI_TIER.  Every rank builds the whole topology;
+ * the links between ranks become remote point-to-point channels.
+ */
+class ClientServerTopology
+{
+public:
+  /// Shape of the topology
+  enum Type
+  {
+    STAR,
+    DUMBBELL,
+    MULTI_TIER
+  };
+
+  ClientServerTopology ();
+
+  /**
+   * \param name "star", "dumbbell" or "multitier"
+   * \return the topology type
+   */
+  static Type ParseType (const std::string &name);
+
+  void SetType (Type type);
+  void SetClientCount (uint32_t count);
+  void SetServerCount (uint32_t count);
+  /**
+   * \param fanOut clients per access router in MULTI_TIER
+   */
+  void SetFanOut (uint32_t fanOut);
+  /**
+   * \param size number of spare addresses per client
+   */
+  void SetAddressPoolSize (uint32_t size);
+  void SetAccessLink (const std::string &rate, const std::string &delay);
+  void SetBottleneckLink (const std::string &rate, const std::string &delay);
+  /**
+   * \param count number of ranks the nodes are partitioned over
+   */
+  void SetSystemCount (uint32_t count);
+
+  /**
+   * \brief Create the nodes, links, internet stacks and addresses, and
+   * populate the global routing tables.
+   */
+  void Build (void);
+
+  NodeContainer GetClients (void) const;
+  NodeContainer GetServers (void) const;
+  NodeContainer GetRouters (void) const;
+
+  /**
+   * \param i the client index
+   * \return the initial address of client i
+   */
+  Ipv4Address GetClientAddress (uint32_t i) const;
+  /**
+   * \param i the client index
+   * \return the Ipv4 interface index of the access link of client i
+   */
+  uint32_t GetClientInterface (uint32_t i) const;
+  /**
+   * \return the network mask of the client subnets
+   */
+  Ipv4Mask GetClientMask (void) const;
+  /**
+   * \param i the client index
+   * \return the spare addresses client i can move to
+   */
+  const std::vector<Ipv4Address> &GetAddressPool (uint32_t i) const;
+  /**
+   * \param i the server index
+   * \return the address of server i
+   */
+  Ipv4Address GetServerAddress (uint32_t i) const;
+  /**
+   * \return the router nearest the clients that all their traffic
+   * crosses: the left router of DUMBBELL, the only or core router
+   * otherwise
+   */
+  Ptr<Node> GetEdgeRouter (void) const;
+  /**
+   * \return an address of the edge router
+   */
+  Ipv4Address GetEdgeRouterAddress (void) const;
+
+private:
+  /**
+   * \brief Link two nodes and address the link from the next subnet.
+   * \param a first node, gets host .1
+   * \param b second node, gets host .2
+   * \param access true for a client-side link
+   * \return the address of a
+   */
+  Ipv4Address Link (Ptr<Node> a, Ptr<Node> b, bool access);
+
+  /**
+   * \param i the client index
+   * \return the rank of client i
+   */
+  uint32_t GetClientSystemId (uint32_t i) const;
+  /**
+   * \param i the access router index, from 0
+   * \return the rank of access router i in MULTI_TIER
+   */
+  uint32_t GetAccessRouterSystemId (uint32_t i) const;
+
+  Type        m_type;              //!< Topology shape
+  uint32_t    m_clientCount;       //!< Number of clients
+  uint32_t    m_serverCount;       //!< Number of servers
+  uint32_t    m_fanOut;            //!< Clients per access router
+  uint32_t    m_poolSize;          //!< Spare addresses per client
+  std::string m_accessRate;        //!< Rate of client-side links
+  std::string m_accessDelay;       //!< Delay of client-side links
+  std::string m_bottleneckRate;    //!< Rate of the other links
+  std::string m_bottleneckDelay;   //!< Delay of the other links
+  uint32_t    m_systemCount;       //!< Number of ranks
+  uint32_t    m_nextSubnet;        //!< Index of the next free /24
+
+  NodeContainer m_clients;         //!< Client nodes
+  NodeContainer m_servers;         //!< Server nodes
+  NodeContainer m_routers;         //!< Router nodes
+  std::vector<Ipv4Address> m_clientAddresses;   //!< Initial client addresses
+  std::vector<uint32_t>    m_clientInterfaces;  //!< Client interface indices
+  std::vector<std::vector<Ipv4Address> > m_pools; //!< Client address pools
+  std::vector<Ipv4Address> m_serverAddresses;   //!< Server addresses
+};
+
+} // namespace ns3
+
+#endif /* CLIENT_SERVER_TOPOLOGY_H */
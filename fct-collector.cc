@@ -0,0 +1,283 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "fct-collector.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FctCollector");
+
+namespace {
+/// Size buckets: up to 1 KiB, 2 KiB, ..., 4 GiB, and larger
+const uint32_t SIZE_BUCKETS = 24;
+/// Largest flow of the first size bucket
+const uint64_t FIRST_SIZE_LIMIT = 1024;
+}
+
+// 1 us to 10000 s, and 1 to 10000, with bins 26% wide
+const FctCollector::Scale FctCollector::s_time = { 1e-6, 10, 101 };
+const FctCollector::Scale FctCollector::s_slowdown = { 1, 10, 41 };
+
+FctCollector::FctCollector ()
+  : m_rate (DataRate ("1Mbps")),
+    m_n (SIZE_BUCKETS, 0),
+    m_completionSum (SIZE_BUCKETS, 0),
+    m_slowdownSum (SIZE_BUCKETS, 0),
+    m_firstByte (SIZE_BUCKETS * s_time.bins, 0),
+    m_completion (SIZE_BUCKETS * s_time.bins, 0),
+    m_slowdown (SIZE_BUCKETS * s_slowdown.bins, 0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+FctCollector::SetReferencePath (DataRate rate, Time delay)
+{
+  NS_LOG_FUNCTION (this << rate << delay);
+  m_rate = rate;
+  m_delay = delay;
+}
+
+void
+FctCollector::Add (uint64_t bytes, Time timeToFirstByte, Time timeToCompletion)
+{
+  NS_LOG_FUNCTION (this << bytes << timeToFirstByte << timeToCompletion);
+  uint32_t bucket = GetSizeBucket (bytes);
+  double completion = timeToCompletion.GetSeconds ();
+  double ideal = m_delay.GetSeconds () + bytes * 8.0 / m_rate.GetBitRate ();
+  double slowdown = ideal > 0 ? completion / ideal : 1;
+  ++m_n[bucket];
+  m_completionSum[bucket] += completion;
+  m_slowdownSum[bucket] += slowdown;
+  ++m_firstByte[bucket * s_time.bins + GetBin (s_time, timeToFirstByte.GetSeconds ())];
+  ++m_completion[bucket * s_time.bins + GetBin (s_time, completion)];
+  ++m_slowdown[bucket * s_slowdown.bins + GetBin (s_slowdown, slowdown)];
+}
+
+void
+FctCollector::Record (uint32_t requestId, uint64_t bytes, Time timeToFirstByte, Time timeToCompletion)
+{
+  Add (bytes, timeToFirstByte, timeToCompletion);
+}
+
+void
+FctCollector::Merge (const FctCollector &other)
+{
+  NS_LOG_FUNCTION (this << &other);
+  for (uint32_t i = 0; i < SIZE_BUCKETS; i++)
+    {
+      m_n[i] += other.m_n[i];
+      m_completionSum[i] += other.m_completionSum[i];
+      m_slowdownSum[i] += other.m_slowdownSum[i];
+    }
+  for (uint32_t i = 0; i < m_completion.size (); i++)
+    {
+      m_firstByte[i] += other.m_firstByte[i];
+      m_completion[i] += other.m_completion[i];
+    }
+  for (uint32_t i = 0; i < m_slowdown.size (); i++)
+    {
+      m_slowdown[i] += other.m_slowdown[i];
+    }
+}
+
+uint64_t
+FctCollector::GetN (void) const
+{
+  uint64_t n = 0;
+  for (uint32_t i = 0; i < SIZE_BUCKETS; i++)
+    {
+      n += m_n[i];
+    }
+  return n;
+}
+
+uint32_t
+FctCollector::GetNSizeBuckets (void)
+{
+  return SIZE_BUCKETS;
+}
+
+uint64_t
+FctCollector::GetSizeLimit (uint32_t bucket)
+{
+  return bucket + 1 < SIZE_BUCKETS ? FIRST_SIZE_LIMIT << bucket : 0;
+}
+
+uint64_t
+FctCollector::GetN (uint32_t bucket) const
+{
+  return m_n[bucket];
+}
+
+Time
+FctCollector::GetMeanCompletion (uint32_t bucket) const
+{
+  return m_n[bucket] > 0 ? Seconds (m_completionSum[bucket] / m_n[bucket]) : Time ();
+}
+
+Time
+FctCollector::GetCompletionPercentile (uint32_t bucket, double p) const
+{
+  return Seconds (Percentile (s_time, &m_completion[bucket * s_time.bins], m_n[bucket], p));
+}
+
+Time
+FctCollector::GetFirstBytePercentile (uint32_t bucket, double p) const
+{
+  return Seconds (Percentile (s_time, &m_firstByte[bucket * s_time.bins], m_n[bucket], p));
+}
+
+double
+FctCollector::GetMeanSlowdown (uint32_t bucket) const
+{
+  return m_n[bucket] > 0 ? m_slowdownSum[bucket] / m_n[bucket] : 0;
+}
+
+double
+FctCollector::GetSlowdownPercentile (uint32_t bucket, double p) const
+{
+  return Percentile (s_slowdown, &m_slowdown[bucket * s_slowdown.bins], m_n[bucket], p);
+}
+
+uint32_t
+FctCollector::GetNTimeBins (void)
+{
+  return s_time.bins;
+}
+
+uint32_t
+FctCollector::GetTimeBin (Time t)
+{
+  return GetBin (s_time, t.GetSeconds ());
+}
+
+Time
+FctCollector::GetTimePercentile (const uint64_t *counts, uint64_t n, double p)
+{
+  return Seconds (Percentile (s_time, counts, n, p));
+}
+
+void
+FctCollector::Print (std::ostream &os) const
+{
+  for (uint32_t i = 0; i < SIZE_BUCKETS; i++)
+    {
+      if (m_n[i] == 0)
+        {
+          continue;
+        }
+      os << "  size ";
+      if (GetSizeLimit (i) > 0)
+        {
+          os << "<= " << GetSizeLimit (i);
+        }
+      else
+        {
+          os << "> " << GetSizeLimit (i - 1);
+        }
+      os << ": " << m_n[i] << " flows"
+         << ", FCT mean/p50/p99 " << GetMeanCompletion (i).GetSeconds () << "/"
+         << GetCompletionPercentile (i, 50).GetSeconds () << "/"
+         << GetCompletionPercentile (i, 99).GetSeconds () << "s"
+         << ", first byte p50 " << GetFirstBytePercentile (i, 50).GetSeconds () << "s"
+         << ", slowdown mean/p99 " << GetMeanSlowdown (i) << "/"
+         << GetSlowdownPercentile (i, 99) << std::endl;
+    }
+}
+
+void
+FctCollector::WriteHistograms (std::ostream &os, const std::string &side) const
+{
+  WriteHistogram (os, side, "firstByte", s_time, m_firstByte);
+  WriteHistogram (os, side, "fct", s_time, m_completion);
+  WriteHistogram (os, side, "slowdown", s_slowdown, m_slowdown);
+}
+
+void
+FctCollector::WriteHistogram (std::ostream &os, const std::string &side, const std::string &metric,
+                              const Scale &scale, const std::vector<uint64_t> &counts) const
+{
+  for (uint32_t i = 0; i < SIZE_BUCKETS; i++)
+    {
+      for (uint32_t bin = 0; m_n[i] > 0 && bin < scale.bins; bin++)
+        {
+          uint64_t count = counts[i * scale.bins + bin];
+          if (count == 0)
+            {
+              continue;
+            }
+          os << side << "," << metric << "," << GetSizeLimit (i) << ","
+             << GetBinLow (scale, bin) << ",";
+          if (bin + 1 < scale.bins)
+            {
+              os << GetBinLow (scale, bin + 1);
+            }
+          os << "," << count << "\n";
+        }
+    }
+}
+
+uint32_t
+FctCollector::GetSizeBucket (uint64_t bytes)
+{
+  uint32_t bucket = 0;
+  while (bucket + 1 < SIZE_BUCKETS && bytes > GetSizeLimit (bucket))
+    {
+      ++bucket;
+    }
+  return bucket;
+}
+
+uint32_t
+FctCollector::GetBin (const Scale &scale, double value)
+{
+  if (value <= scale.lowest)
+    {
+      return 0;
+    }
+  double bin = 1 + std::floor (scale.perDecade * std::log10 (value / scale.lowest));
+  return static_cast<uint32_t> (std::min<double> (bin, scale.bins - 1));
+}
+
+double
+FctCollector::GetBinLow (const Scale &scale, uint32_t bin)
+{
+  if (bin == 0)
+    {
+      return 0;
+    }
+  return scale.lowest * std::pow (10.0, (bin - 1.0) / scale.perDecade);
+}
+
+double
+FctCollector::Percentile (const Scale &scale, const uint64_t *counts, uint64_t n, double p)
+{
+  if (n == 0)
+    {
+      return 0;
+    }
+  // Nearest rank, then the middle of its bin
+  double rank = std::max (1.0, std::ceil (p / 100.0 * n));
+  uint64_t seen = 0;
+  uint32_t bin = 0;
+  while (bin + 1 < scale.bins && seen + counts[bin] < rank)
+    {
+      seen += counts[bin];
+      ++bin;
+    }
+  if (bin == 0)
+    {
+      return scale.lowest;
+    }
+  if (bin + 1 == scale.bins)
+    {
+      return GetBinLow (scale, bin);
+    }
+  return std::sqrt (GetBinLow (scale, bin) * GetBinLow (scale, bin + 1));
+}
+
+} // namespace ns3
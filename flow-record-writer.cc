@@ -0,0 +1,98 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "flow-record-writer.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FlowRecordWriter");
+
+FlowRecordWriter::FlowRecordWriter ()
+  : m_file (0),
+    m_used (0),
+    m_records (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+FlowRecordWriter::~FlowRecordWriter ()
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+}
+
+bool
+FlowRecordWriter::Open (const std::string &filename, uint32_t bufferSize)
+{
+  NS_LOG_FUNCTION (this << filename << bufferSize);
+  Close ();
+  m_file = std::fopen (filename.c_str (), "wb");
+  if (!m_file)
+    {
+      NS_LOG_WARN ("Cannot create " << filename);
+      return false;
+    }
+  // Buffering is done here, in blocks of whole records
+  std::setvbuf (m_file, 0, _IONBF, 0);
+  m_buffer.resize (std::max<uint32_t> (bufferSize, sizeof (Record)));
+  m_used = 0;
+  m_records = 0;
+
+  char header[8] = { 'T', 'C', 'F', 'R' };
+  uint16_t version = 1;
+  uint16_t recordSize = sizeof (Record);
+  std::memcpy (header + 4, &version, sizeof (version));
+  std::memcpy (header + 6, &recordSize, sizeof (recordSize));
+  std::fwrite (header, sizeof (header), 1, m_file);
+  return true;
+}
+
+void
+FlowRecordWriter::Write (const Record &record)
+{
+  if (!m_file)
+    {
+      return;
+    }
+  if (m_used + sizeof (Record) > m_buffer.size ())
+    {
+      Flush ();
+    }
+  std::memcpy (&m_buffer[m_used], &record, sizeof (Record));
+  m_used += sizeof (Record);
+  m_records++;
+}
+
+void
+FlowRecordWriter::Flush (void)
+{
+  NS_LOG_FUNCTION (this << m_used);
+  if (m_file && m_used > 0)
+    {
+      std::fwrite (&m_buffer[0], 1, m_used, m_file);
+    }
+  m_used = 0;
+}
+
+void
+FlowRecordWriter::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_file)
+    {
+      Flush ();
+      std::fclose (m_file);
+      m_file = 0;
+    }
+}
+
+uint64_t
+FlowRecordWriter::GetRecordCount (void) const
+{
+  return m_records;
+}
+
+} // namespace ns3
@@ -0,0 +1,88 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef FLOW_RECORD_WRITER_H
+#define FLOW_RECORD_WRITER_H
+
+#include <stdint.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup tcpserver
+ * \brief Writes fixed-size binary flow records through a large buffer.
+ *
+ * The file starts with the 8 bytes "TCFR", a uint16_t version and a
+ * uint16_t record size, followed by Record structures in host byte order.
+ * Records are collected in memory and written in blocks of the buffer
+ * size, so a run that only wants flow summaries does one write per
+ * block instead of one per packet.
+ */
+class FlowRecordWriter
+{
+public:
+  /// Kind of a record
+  enum RecordType
+  {
+    TRANSFER = 1,       //!< A completed request of a client
+    CLIENT_SUMMARY = 2, //!< Totals of a client at the end of the run
+    PACKET = 3          //!< A sampled packet received by a device
+  };
+
+  /// One record of the file
+  struct Record
+  {
+    uint32_t type;  //!< RecordType
+    uint32_t node;  //!< Node id
+    uint32_t id;    //!< Request id, request count or device index
+    uint32_t size;  //!< Packet size, zero for other records
+    uint64_t bytes; //!< Bytes transferred
+    int64_t  time;  //!< Simulation time of the record, in ns
+    int64_t  t1;    //!< Time to first byte, in ns
+    int64_t  t2;    //!< Time to completion, in ns
+  };
+
+  FlowRecordWriter ();
+  ~FlowRecordWriter ();
+
+  /**
+   * \brief Create the file and write its header.
+   * \param filename the file name
+   * \param bufferSize the size of the blocks written, in bytes
+   * \return false if the file cannot be created
+   */
+  bool Open (const std::string &filename, uint32_t bufferSize);
+
+  /**
+   * \brief Append a record, writing the buffer out once it is full.
+   * \param record the record
+   */
+  void Write (const Record &record);
+
+  /**
+   * \brief Write out the buffered records.
+   */
+  void Flush (void);
+
+  /**
+   * \brief Flush and close the file.
+   */
+  void Close (void);
+
+  /**
+   * \return the number of records written so far
+   */
+  uint64_t GetRecordCount (void) const;
+
+private:
+  std::FILE *m_file;          //!< Output file
+  std::vector<char> m_buffer; //!< Records not written yet
+  uint32_t m_used;            //!< Bytes used in m_buffer
+  uint64_t m_records;         //!< Records written
+};
+
+} // namespace ns3
+
+#endif /* FLOW_RECORD_WRITER_H */
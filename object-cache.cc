@@ -0,0 +1,145 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "object-cache.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ObjectCache");
+
+bool
+ObjectCache::Rank::operator< (const Rank &other) const
+{
+  if (primary != other.primary)
+    {
+      return primary < other.primary;
+    }
+  if (lastUse != other.lastUse)
+    {
+      return lastUse < other.lastUse;
+    }
+  return key < other.key;
+}
+
+ObjectCache::ObjectCache ()
+  : m_policy (LRU),
+    m_capacity (0),
+    m_bytes (0),
+    m_clock (0),
+    m_evictions (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+ObjectCache::SetPolicy (Policy policy)
+{
+  NS_LOG_FUNCTION (this << policy);
+  NS_ASSERT_MSG (m_entries.empty (), "Set the policy of an empty cache");
+  m_policy = policy;
+}
+
+void
+ObjectCache::SetCapacity (uint64_t capacity)
+{
+  NS_LOG_FUNCTION (this << capacity);
+  m_capacity = capacity;
+}
+
+ObjectCache::Rank
+ObjectCache::MakeRank (const Entry &entry, const Key &key) const
+{
+  Rank rank;
+  switch (m_policy)
+    {
+    case LRU:
+      rank.primary = 0;
+      break;
+    case LFU:
+      rank.primary = entry.uses;
+      break;
+    case SIZE:
+      rank.primary = -static_cast<int64_t> (key.second);
+      break;
+    }
+  rank.lastUse = m_clock;
+  rank.key = key;
+  return rank;
+}
+
+bool
+ObjectCache::Lookup (uint32_t id, uint64_t size)
+{
+  NS_LOG_FUNCTION (this << id << size);
+  Key key (id, size);
+  std::map<Key, Entry>::iterator it = m_entries.find (key);
+  if (it == m_entries.end ())
+    {
+      return false;
+    }
+  ++it->second.uses;
+  Touch (key, it->second);
+  return true;
+}
+
+bool
+ObjectCache::Insert (uint32_t id, uint64_t size)
+{
+  NS_LOG_FUNCTION (this << id << size);
+  if (size > m_capacity)
+    {
+      return false;
+    }
+  Key key (id, size);
+  std::map<Key, Entry>::iterator it = m_entries.find (key);
+  if (it != m_entries.end ())
+    {
+      Touch (key, it->second);
+      return true;
+    }
+  while (m_bytes + size > m_capacity)
+    {
+      Key victim = m_order.begin ()->key;
+      NS_LOG_LOGIC ("evicting object " << victim.first << " of " << victim.second << " bytes");
+      m_order.erase (m_order.begin ());
+      m_entries.erase (victim);
+      m_bytes -= victim.second;
+      ++m_evictions;
+    }
+  ++m_clock;
+  Entry &entry = m_entries[key];
+  entry.uses = 1;
+  entry.rank = MakeRank (entry, key);
+  m_order.insert (entry.rank);
+  m_bytes += size;
+  return true;
+}
+
+void
+ObjectCache::Touch (const Key &key, Entry &entry)
+{
+  ++m_clock;
+  m_order.erase (entry.rank);
+  entry.rank = MakeRank (entry, key);
+  m_order.insert (entry.rank);
+}
+
+uint32_t
+ObjectCache::GetN (void) const
+{
+  return m_entries.size ();
+}
+
+uint64_t
+ObjectCache::GetBytes (void) const
+{
+  return m_bytes;
+}
+
+uint64_t
+ObjectCache::GetEvictions (void) const
+{
+  return m_evictions;
+}
+
+} // namespace ns3
@@ -0,0 +1,128 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef OBJECT_CACHE_H
+#define OBJECT_CACHE_H
+
+#include <stdint.h>
+#include <map>
+#include <set>
+#include <utility>
+
+namespace ns3 {
+
+/**
+ * \ingroup tcpserver
+ * \brief Bookkeeping of a byte-bounded object cache.
+ *
+ * An object is named by its id and its size; only its size counts, the
+ * payload itself is synthetic.  When an insertion overflows the capacity,
+ * objects are evicted in the order of the policy:
+ *
+ * - LRU: least recently used first;
+ * - LFU: least frequently used first, then least recently used;
+ * - SIZE: largest first, then least recently used, which keeps many
+ *   small objects and favours the object hit ratio.
+ *
+ * Lookups, insertions and evictions are O(log n).
+ */
+class ObjectCache
+{
+public:
+  /// Eviction order
+  enum Policy
+  {
+    LRU,
+    LFU,
+    SIZE
+  };
+
+  /// Name of an object: id and size
+  typedef std::pair<uint32_t, uint64_t> Key;
+
+  ObjectCache ();
+
+  /**
+   * \param policy the eviction policy
+   */
+  void SetPolicy (Policy policy);
+  /**
+   * \param capacity the bytes the objects may take
+   */
+  void SetCapacity (uint64_t capacity);
+
+  /**
+   * \brief Look an object up, and count a use of it if present.
+   * \param id the object id
+   * \param size the object size
+   * \return true if the object is cached
+   */
+  bool Lookup (uint32_t id, uint64_t size);
+  /**
+   * \brief Insert an object, evicting others until it fits. Objects
+   * larger than the capacity are not inserted; an object already cached
+   * becomes the most recently used, without counting a use of it.
+   * \param id the object id
+   * \param size the object size
+   * \return true if the object is cached
+   */
+  bool Insert (uint32_t id, uint64_t size);
+
+  /**
+   * \return the number of cached objects
+   */
+  uint32_t GetN (void) const;
+  /**
+   * \return the bytes of the cached objects
+   */
+  uint64_t GetBytes (void) const;
+  /**
+   * \return the number of objects evicted so far
+   */
+  uint64_t GetEvictions (void) const;
+
+private:
+  /// Eviction rank: objects are evicted from the smallest rank up
+  struct Rank
+  {
+    int64_t  primary;  //!< Use count for LFU, minus the size for SIZE
+    uint64_t lastUse;  //!< Use clock at the last use
+    Key      key;      //!< Object
+    /**
+     * \param other the other rank
+     * \return true if this object goes first
+     */
+    bool operator< (const Rank &other) const;
+  };
+
+  /// A cached object
+  struct Entry
+  {
+    uint64_t uses;     //!< Uses since insertion
+    Rank     rank;     //!< Its place in the eviction order
+  };
+
+  /**
+   * \param entry the entry to rank
+   * \param key the object
+   * \return the rank of the entry under the policy
+   */
+  Rank MakeRank (const Entry &entry, const Key &key) const;
+  /**
+   * \brief Make an entry the most recently used, and rank it again.
+   * \param key the object
+   * \param entry its entry
+   */
+  void Touch (const Key &key, Entry &entry);
+
+  Policy   m_policy;     //!< Eviction policy
+  uint64_t m_capacity;   //!< Capacity in bytes
+  uint64_t m_bytes;      //!< Bytes of the cached objects
+  uint64_t m_clock;      //!< Use clock
+  uint64_t m_evictions;  //!< Objects evicted
+  std::map<Key, Entry> m_entries;  //!< Cached objects
+  std::set<Rank>       m_order;    //!< Eviction order
+};
+
+} // namespace ns3
+
+#endif /* OBJECT_CACHE_H */
@@ -0,0 +1,129 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+// Microbenchmark of the server payload path: generates a given volume of
+// payload with Create<Packet> and with TcpPayloadSource, and reports heap
+// allocations and wall-clock time for each, scaled to one GB.
+//
+// Allocations are counted by replacing the global operator new, so this is
+// a program of its own rather than an option of tcp-sender-receiver: put it
+// in a scratch directory of its own with tcp-payload-source.{h,cc}, see
+// the Readme.
+
+#include "ns3/command-line.h"
+#include "ns3/packet.h"
+#include "tcp-payload-source.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+static uint64_t g_allocations = 0;
+
+void *
+operator new (std::size_t size)
+{
+  ++g_allocations;
+  void *p = std::malloc (size ? size : 1);
+  if (!p)
+    {
+      throw std::bad_alloc ();
+    }
+  return p;
+}
+
+void
+operator delete (void *p) noexcept
+{
+  std::free (p);
+}
+
+void
+operator delete (void *p, std::size_t) noexcept
+{
+  std::free (p);
+}
+
+namespace ns3 {
+
+namespace {
+
+struct PayloadBenchResult
+{
+  uint64_t allocations;
+  double   seconds;
+};
+
+template <typename F>
+PayloadBenchResult
+MeasurePayload (uint64_t totalBytes, uint32_t sendSize, F makePacket)
+{
+  uint64_t sent = 0;
+  uint64_t allocBefore = g_allocations;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  while (sent < totalBytes)
+    {
+      uint32_t toSend = static_cast<uint32_t> (std::min<uint64_t> (sendSize, totalBytes - sent));
+      Ptr<Packet> packet = makePacket (toSend);
+      sent += packet->GetSize ();
+    }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now () - start;
+  PayloadBenchResult result;
+  result.allocations = g_allocations - allocBefore;
+  result.seconds = elapsed.count ();
+  return result;
+}
+
+void
+PrintPayload (const char *name, uint64_t totalBytes, const PayloadBenchResult &r)
+{
+  double perGb = (1024.0 * 1024.0 * 1024.0) / totalBytes;
+  std::cout << name
+            << ": allocations/GB " << static_cast<uint64_t> (r.allocations * perGb)
+            << ", wall-clock s/GB " << r.seconds * perGb
+            << std::endl;
+}
+
+/**
+ * \brief Compare allocations and wall-clock time of Create<Packet> against
+ * TcpPayloadSource for a given volume of payload, and print the result.
+ * \param totalBytes bytes of payload to generate with each method
+ * \param sendSize size of each chunk
+ */
+void
+RunPayloadBenchmark (uint64_t totalBytes, uint32_t sendSize)
+{
+  std::cout << "Payload benchmark: " << totalBytes << " bytes in "
+            << sendSize << " byte chunks" << std::endl;
+
+  PayloadBenchResult legacy = MeasurePayload (totalBytes, sendSize,
+                                              [] (uint32_t size) { return Create<Packet> (size); });
+  PrintPayload ("Create<Packet>  ", totalBytes, legacy);
+
+  Ptr<TcpPayloadSource> source = Create<TcpPayloadSource> (sendSize);
+  PayloadBenchResult pooled = MeasurePayload (totalBytes, sendSize,
+                                              [source] (uint32_t size) { return source->Get (size); });
+  PrintPayload ("TcpPayloadSource", totalBytes, pooled);
+}
+
+} // anonymous namespace
+
+} // namespace ns3
+
+using namespace ns3;
+
+int
+main (int argc, char *argv[])
+{
+  uint64_t totalBytes = (1024*1024*1024ULL);
+  uint32_t sendSize = 512;
+
+  CommandLine cmd;
+  cmd.AddValue ("totalBytes", "Bytes of payload generated by each method", totalBytes);
+  cmd.AddValue ("sendSize", "Size of each chunk", sendSize);
+  cmd.Parse (argc, argv);
+
+  RunPayloadBenchmark (totalBytes, std::max<uint32_t> (sendSize, 1));
+  return 0;
+}
@@ -0,0 +1,123 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "scenario-worker-pool.h"
+
+#include <cerrno>
+#include <iostream>
+#include <map>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ScenarioWorkerPool");
+
+ScenarioWorkerPool::ScenarioWorkerPool ()
+  : m_jobs (1)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+ScenarioWorkerPool::SetJobs (uint32_t jobs)
+{
+  NS_LOG_FUNCTION (this << jobs);
+  if (jobs == 0)
+    {
+      long cpus = sysconf (_SC_NPROCESSORS_ONLN);
+      jobs = cpus > 0 ? cpus : 1;
+    }
+  m_jobs = jobs;
+}
+
+uint32_t
+ScenarioWorkerPool::GetJobs (void) const
+{
+  return m_jobs;
+}
+
+void
+ScenarioWorkerPool::Run (const std::vector<ScenarioConfig> &configs,
+                         std::vector<ScenarioResult> &results, std::vector<bool> &ok)
+{
+  NS_LOG_FUNCTION (this << configs.size ());
+  results.assign (configs.size (), ScenarioResult ());
+  ok.assign (configs.size (), false);
+
+  // Running workers: pid to index of the configuration and read end of its pipe
+  std::map<pid_t, std::pair<uint32_t, int> > running;
+  uint32_t next = 0;
+  while (next < configs.size () || !running.empty ())
+    {
+      while (running.size () < m_jobs && next < configs.size ())
+        {
+          int fds[2];
+          if (pipe (fds) != 0)
+            {
+              NS_LOG_WARN ("pipe failed: " << errno);
+              next++;
+              continue;
+            }
+          std::cout.flush ();
+          pid_t pid = fork ();
+          if (pid < 0)
+            {
+              NS_LOG_WARN ("fork failed: " << errno);
+              close (fds[0]);
+              close (fds[1]);
+              next++;
+              continue;
+            }
+          if (pid == 0)
+            {
+              close (fds[0]);
+              ScenarioResult result = RunScenario (configs[next]);
+              ssize_t written = write (fds[1], &result, sizeof (result));
+              close (fds[1]);
+              _exit (written == sizeof (result) ? 0 : 1);
+            }
+          close (fds[1]);
+          NS_LOG_INFO ("Run " << next + 1 << "/" << configs.size () << " started");
+          running[pid] = std::make_pair (next++, fds[0]);
+        }
+      if (running.empty ())
+        {
+          break;
+        }
+
+      int status = 0;
+      pid_t pid = waitpid (-1, &status, 0);
+      if (pid < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+          NS_LOG_WARN ("waitpid failed: " << errno);
+          break;
+        }
+      std::map<pid_t, std::pair<uint32_t, int> >::iterator it = running.find (pid);
+      if (it == running.end ())
+        {
+          continue;
+        }
+      uint32_t index = it->second.first;
+      int fd = it->second.second;
+      running.erase (it);
+
+      ssize_t got;
+      do
+        {
+          got = read (fd, &results[index], sizeof (ScenarioResult));
+        }
+      while (got < 0 && errno == EINTR);
+      close (fd);
+      ok[index] = got == sizeof (ScenarioResult) && WIFEXITED (status) && WEXITSTATUS (status) == 0;
+      NS_LOG_INFO ("Run " << index + 1 << "/" << configs.size ()
+                   << (ok[index] ? " done" : " failed"));
+    }
+}
+
+} // namespace ns3
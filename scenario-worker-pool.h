@@ -0,0 +1,51 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef SCENARIO_WORKER_POOL_H
+#define SCENARIO_WORKER_POOL_H
+
+#include "tcp-client-server.h"
+
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief Runs scenarios in child processes, several at a time.
+ *
+ * The simulator is a process-wide singleton, so independent runs are
+ * parallelised by forking one worker per run, at most GetJobs () at a
+ * time.  A worker returns its ScenarioResult through a pipe; the result
+ * is smaller than PIPE_BUF, so the write never blocks and the parent can
+ * collect it once the worker has exited.
+ */
+class ScenarioWorkerPool
+{
+public:
+  ScenarioWorkerPool ();
+
+  /**
+   * \param jobs the maximum number of concurrent workers, 0 for one per
+   *        online CPU
+   */
+  void SetJobs (uint32_t jobs);
+  /**
+   * \return the maximum number of concurrent workers
+   */
+  uint32_t GetJobs (void) const;
+
+  /**
+   * \brief Run every configuration in a worker process of its own.
+   * \param configs the configurations
+   * \param [out] results the result of each configuration
+   * \param [out] ok whether each worker completed and returned its result
+   */
+  void Run (const std::vector<ScenarioConfig> &configs,
+            std::vector<ScenarioResult> &results, std::vector<bool> &ok);
+
+private:
+  uint32_t m_jobs; //!< Maximum number of concurrent workers
+};
+
+} // namespace ns3
+
+#endif /* SCENARIO_WORKER_POOL_H */
@@ -0,0 +1,278 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "ns3/enum.h"
+#include "ns3/hash.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/node.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "server-pool.h"
+#include "tcp-server-application.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ServerPool");
+
+NS_OBJECT_ENSURE_REGISTERED (ServerSelector);
+
+TypeId
+ServerSelector::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ServerSelector")
+    .SetParent<Object> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<ServerSelector> ()
+    .AddAttribute ("Policy",
+                   "How the server of a client is picked.",
+                   EnumValue (ROUND_ROBIN),
+                   MakeEnumAccessor (&ServerSelector::m_policy),
+                   MakeEnumChecker (ROUND_ROBIN, "RoundRobin",
+                                    LEAST_OUTSTANDING, "LeastOutstanding",
+                                    POWER_OF_TWO, "PowerOfTwo",
+                                    CONSISTENT_HASH, "ConsistentHash"))
+    .AddAttribute ("VirtualNodes",
+                   "The points of each server on the ring of ConsistentHash.",
+                   UintegerValue (64),
+                   MakeUintegerAccessor (&ServerSelector::m_virtualNodes),
+                   MakeUintegerChecker<uint32_t> (1))
+  ;
+  return tid;
+}
+
+ServerSelector::ServerSelector ()
+{
+  NS_LOG_FUNCTION (this);
+  m_random = CreateObject<UniformRandomVariable> ();
+}
+
+void
+ServerSelector::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_random = 0;
+  Object::DoDispose ();
+}
+
+uint32_t
+ServerSelector::AddServer (const Address &address)
+{
+  NS_LOG_FUNCTION (this << address);
+  Server server;
+  server.address = address;
+  server.clients = 0;
+  server.requests = 0;
+  server.completed = 0;
+  server.bytes = 0;
+  server.outstanding = 0;
+  server.peakOutstanding = 0;
+  m_servers.push_back (server);
+  m_ring.clear ();
+  return m_servers.size () - 1;
+}
+
+uint32_t
+ServerSelector::GetNServers (void) const
+{
+  return m_servers.size ();
+}
+
+const Address &
+ServerSelector::GetServer (uint32_t server) const
+{
+  return m_servers[server].address;
+}
+
+uint32_t
+ServerSelector::Select (uint32_t clientId)
+{
+  NS_LOG_FUNCTION (this << clientId);
+  NS_ASSERT_MSG (!m_servers.empty (), "No server to select from");
+  uint32_t server = 0;
+  switch (m_policy)
+    {
+    case ROUND_ROBIN:
+      server = clientId % m_servers.size ();
+      break;
+    case LEAST_OUTSTANDING:
+      // Ties go to the server with the fewest clients, then the first
+      for (uint32_t i = 1; i < m_servers.size (); i++)
+        {
+          if (m_servers[i].outstanding < m_servers[server].outstanding
+              || (m_servers[i].outstanding == m_servers[server].outstanding
+                  && m_servers[i].clients < m_servers[server].clients))
+            {
+              server = i;
+            }
+        }
+      break;
+    case POWER_OF_TWO:
+      {
+        uint32_t n = m_servers.size ();
+        uint32_t a = m_random->GetInteger (0, n - 1);
+        uint32_t b = n > 1 ? (a + m_random->GetInteger (1, n - 1)) % n : a;
+        server = m_servers[b].outstanding < m_servers[a].outstanding ? b : a;
+      }
+      break;
+    case CONSISTENT_HASH:
+      server = SelectByHash (clientId);
+      break;
+    }
+  ++m_servers[server].clients;
+  NS_LOG_INFO ("Client " << clientId << " picks server " << server << " at "
+               << m_servers[server].address);
+  return server;
+}
+
+uint32_t
+ServerSelector::SelectByHash (uint32_t clientId)
+{
+  if (m_ring.empty ())
+    {
+      for (uint32_t i = 0; i < m_servers.size (); i++)
+        {
+          for (uint32_t v = 0; v < m_virtualNodes; v++)
+            {
+              std::ostringstream point;
+              point << "server-" << i << "-" << v;
+              m_ring.push_back (std::make_pair (Hash32 (point.str ()), i));
+            }
+        }
+      std::sort (m_ring.begin (), m_ring.end ());
+    }
+  std::ostringstream client;
+  client << "client-" << clientId;
+  std::pair<uint32_t, uint32_t> key (Hash32 (client.str ()), 0);
+  std::vector<std::pair<uint32_t, uint32_t> >::const_iterator it =
+    std::lower_bound (m_ring.begin (), m_ring.end (), key);
+  return it == m_ring.end () ? m_ring.front ().second : it->second;
+}
+
+void
+ServerSelector::RequestStarted (uint32_t server)
+{
+  NS_LOG_FUNCTION (this << server);
+  Server &s = m_servers[server];
+  ++s.requests;
+  ++s.outstanding;
+  s.peakOutstanding = std::max (s.peakOutstanding, s.outstanding);
+}
+
+void
+ServerSelector::RequestCompleted (uint32_t server, uint64_t bytes)
+{
+  NS_LOG_FUNCTION (this << server << bytes);
+  Server &s = m_servers[server];
+  ++s.completed;
+  s.bytes += bytes;
+  --s.outstanding;
+}
+
+void
+ServerSelector::RequestAbandoned (uint32_t server)
+{
+  NS_LOG_FUNCTION (this << server);
+  --m_servers[server].outstanding;
+}
+
+uint32_t
+ServerSelector::GetClients (uint32_t server) const
+{
+  return m_servers[server].clients;
+}
+
+uint64_t
+ServerSelector::GetRequests (uint32_t server) const
+{
+  return m_servers[server].requests;
+}
+
+uint64_t
+ServerSelector::GetCompletedRequests (uint32_t server) const
+{
+  return m_servers[server].completed;
+}
+
+uint64_t
+ServerSelector::GetBytes (uint32_t server) const
+{
+  return m_servers[server].bytes;
+}
+
+uint32_t
+ServerSelector::GetOutstanding (uint32_t server) const
+{
+  return m_servers[server].outstanding;
+}
+
+uint32_t
+ServerSelector::GetPeakOutstanding (uint32_t server) const
+{
+  return m_servers[server].peakOutstanding;
+}
+
+int64_t
+ServerSelector::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  m_random->SetStream (stream);
+  return 1;
+}
+
+/************************************************************************************/
+
+ServerPoolHelper::ServerPoolHelper (uint16_t port)
+  : m_port (port)
+{
+  m_factory.SetTypeId (TcpServerApplication::GetTypeId ());
+  m_selectorFactory.SetTypeId (ServerSelector::GetTypeId ());
+  SetAttribute ("Local", AddressValue (InetSocketAddress (Ipv4Address::GetAny (), port)));
+}
+
+void
+ServerPoolHelper::SetAttribute (std::string name, const AttributeValue &value)
+{
+  m_factory.Set (name, value);
+}
+
+void
+ServerPoolHelper::SetSelectorAttribute (std::string name, const AttributeValue &value)
+{
+  m_selectorFactory.Set (name, value);
+}
+
+ApplicationContainer
+ServerPoolHelper::Install (NodeContainer nodes, const std::vector<Ipv4Address> &addresses)
+{
+  NS_ASSERT_MSG (nodes.GetN () == addresses.size (), "One address per server node");
+  Ptr<ServerSelector> selector = GetSelector ();
+  ApplicationContainer apps;
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      selector->AddServer (InetSocketAddress (addresses[i], m_port));
+      // In a distributed simulation, only the rank of the node runs it
+      if (nodes.Get (i)->GetSystemId () != Simulator::GetSystemId ())
+        {
+          continue;
+        }
+      Ptr<Application> app = m_factory.Create<Application> ();
+      nodes.Get (i)->AddApplication (app);
+      apps.Add (app);
+    }
+  return apps;
+}
+
+Ptr<ServerSelector>
+ServerPoolHelper::GetSelector (void)
+{
+  if (!m_selector)
+    {
+      m_selector = m_selectorFactory.Create<ServerSelector> ();
+    }
+  return m_selector;
+}
+
+} // namespace ns3
@@ -0,0 +1,220 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef SERVER_POOL_H
+#define SERVER_POOL_H
+
+#include "ns3/address.h"
+#include "ns3/application-container.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/node-container.h"
+#include "ns3/object.h"
+#include "ns3/object-factory.h"
+#include "ns3/ptr.h"
+#include "ns3/random-variable-stream.h"
+
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup clientsend
+ * \brief Picks the server of a client among the servers of a pool, and
+ * keeps the load of every server.
+ *
+ * One selector is shared by the clients of a pool, so its view of the
+ * load is that of a client-side load balancer that sees every request.
+ * The policies are:
+ *
+ * - RoundRobin: the servers in turn, by client id;
+ * - LeastOutstanding: the server with the fewest outstanding requests;
+ * - PowerOfTwo: the less loaded of two servers drawn at random;
+ * - ConsistentHash: the server following the hash of the client id on a
+ *   ring with VirtualNodes points per server, so that a client keeps its
+ *   server and few clients move when servers are added.
+ *
+ * Clients report the requests they issue and complete, see
+ * TcpClientApplication's ServerSelector attribute.
+ */
+class ServerSelector : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  /// How a server is picked
+  enum Policy
+  {
+    ROUND_ROBIN,
+    LEAST_OUTSTANDING,
+    POWER_OF_TWO,
+    CONSISTENT_HASH
+  };
+
+  ServerSelector ();
+
+  /**
+   * \param address the address of a new server of the pool
+   * \return the index of the server
+   */
+  uint32_t AddServer (const Address &address);
+  /**
+   * \return the number of servers
+   */
+  uint32_t GetNServers (void) const;
+  /**
+   * \param server the server index
+   * \return the address of the server
+   */
+  const Address &GetServer (uint32_t server) const;
+
+  /**
+   * \brief Pick the server of a client.
+   *
+   * RoundRobin and ConsistentHash depend on the client id alone, so every
+   * rank of a distributed simulation picks the same server for a client.
+   * The other policies depend on the load this selector has seen.
+   *
+   * \param clientId the id of the client
+   * \return the server index
+   */
+  uint32_t Select (uint32_t clientId);
+
+  /**
+   * \brief A client issued a request to a server.
+   * \param server the server index
+   */
+  void RequestStarted (uint32_t server);
+  /**
+   * \brief A request to a server has been fully answered.
+   * \param server the server index
+   * \param bytes the size of the response
+   */
+  void RequestCompleted (uint32_t server, uint64_t bytes);
+  /**
+   * \brief A client dropped a request it will issue again.
+   * \param server the server index
+   */
+  void RequestAbandoned (uint32_t server);
+
+  /**
+   * \param server the server index
+   * \return the clients that picked the server
+   */
+  uint32_t GetClients (uint32_t server) const;
+  /**
+   * \param server the server index
+   * \return the requests issued to the server
+   */
+  uint64_t GetRequests (uint32_t server) const;
+  /**
+   * \param server the server index
+   * \return the requests fully answered by the server
+   */
+  uint64_t GetCompletedRequests (uint32_t server) const;
+  /**
+   * \param server the server index
+   * \return the bytes of the answered requests
+   */
+  uint64_t GetBytes (uint32_t server) const;
+  /**
+   * \param server the server index
+   * \return the requests outstanding at the server
+   */
+  uint32_t GetOutstanding (uint32_t server) const;
+  /**
+   * \param server the server index
+   * \return the largest number of requests outstanding at once
+   */
+  uint32_t GetPeakOutstanding (uint32_t server) const;
+
+  /**
+   * \brief Use a fixed random variable stream for PowerOfTwo.
+   * \param stream the stream index to use
+   * \return the number of stream indices used
+   */
+  int64_t AssignStreams (int64_t stream);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /// Load of one server
+  struct Server
+  {
+    Address  address;         //!< Address of the server
+    uint32_t clients;         //!< Clients that picked it
+    uint64_t requests;        //!< Requests issued to it
+    uint64_t completed;       //!< Requests it fully answered
+    uint64_t bytes;           //!< Bytes of the answered requests
+    uint32_t outstanding;     //!< Requests outstanding
+    uint32_t peakOutstanding; //!< Largest number outstanding at once
+  };
+
+  /**
+   * \param clientId the client id
+   * \return the server following the hash of the client on the ring
+   */
+  uint32_t SelectByHash (uint32_t clientId);
+
+  Policy   m_policy;       //!< Selection policy
+  uint32_t m_virtualNodes; //!< Ring points per server
+  std::vector<Server> m_servers;  //!< Servers of the pool
+  std::vector<std::pair<uint32_t, uint32_t> > m_ring; //!< Sorted hash, server
+  Ptr<UniformRandomVariable> m_random; //!< Draws of PowerOfTwo
+};
+
+/**
+ * \ingroup clientsend
+ * \brief Installs a TcpServerApplication on each server of a pool and
+ * registers it with the pool's ServerSelector.
+ */
+class ServerPoolHelper
+{
+public:
+  /**
+   * \param port the port the servers listen on
+   */
+  ServerPoolHelper (uint16_t port);
+
+  /**
+   * \param name the name of a TcpServerApplication attribute
+   * \param value its value for every server
+   */
+  void SetAttribute (std::string name, const AttributeValue &value);
+  /**
+   * \param name the name of a ServerSelector attribute
+   * \param value its value
+   */
+  void SetSelectorAttribute (std::string name, const AttributeValue &value);
+
+  /**
+   * \brief Install a server on every node.
+   * \param nodes the server nodes
+   * \param addresses the address clients reach each node at
+   * \returns the servers installed; in a distributed simulation, the
+   * nodes of other ranks are registered with the selector but get no
+   * application on this rank
+   */
+  ApplicationContainer Install (NodeContainer nodes, const std::vector<Ipv4Address> &addresses);
+
+  /**
+   * \return the selector of the pool, to give to its clients
+   */
+  Ptr<ServerSelector> GetSelector (void);
+
+private:
+  uint16_t            m_port;     //!< Port of the servers
+  ObjectFactory       m_factory;  //!< Server factory
+  ObjectFactory       m_selectorFactory; //!< Selector factory
+  Ptr<ServerSelector> m_selector; //!< Selector, created on first use
+};
+
+} // namespace ns3
+
+#endif /* SERVER_POOL_H */
@@ -7,9 +7,15 @@
 #include "ns3/socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/pointer.h"
+#include "ns3/string.h"
+#include "ns3/nstime.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/tcp-socket-factory.h"
 #include "tcp-client-application.h"
+#include "tcp-request-header.h"
+#include "tcp-socket-options.h"
 #include "ns3/names.h"
 
 namespace ns3 {
@@ -30,9 +36,152 @@ TcpClientApplication::GetTypeId (void)
                    MakeAddressAccessor (&TcpClientApplication::m_peer),
                    MakeAddressChecker ())
     .AddAttribute ("MaxRxBytes",
-                   "The total number of bytes expected to recieve",
+                   "The size of each requested object. "
+                   "The value zero asks for the server's MaxTxBytes.",
                    UintegerValue (0),
                    MakeUintegerAccessor (&TcpClientApplication::m_maxRx),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("NumRequests",
+                   "The number of requests issued on the connection. "
+                   "More than one needs a Persistent server. "
+                   "The value zero means that there is no limit.",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&TcpClientApplication::m_numRequests),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("PipelineDepth",
+                   "The number of requests kept outstanding at once.",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&TcpClientApplication::m_pipelineDepth),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("Resume",
+                   "If true, a reconnection asks the server for the rest of "
+                   "the transfer instead of starting it over.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpClientApplication::m_resume),
+                   MakeBooleanChecker ())
+    .AddAttribute ("SessionId",
+                   "The session id sent in requests. "
+                   "The value zero picks a unique id from the node id "
+                   "and the application index.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&TcpClientApplication::m_sessionId),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("ObjectSize",
+                   "The random variable the size of each requested object, "
+                   "in bytes, is drawn from. If unset, every request asks "
+                   "for MaxRxBytes.",
+                   PointerValue (),
+                   MakePointerAccessor (&TcpClientApplication::m_objectSize),
+                   MakePointerChecker<RandomVariableStream> ())
+    .AddAttribute ("ObjectId",
+                   "The random variable the id of each requested object is "
+                   "drawn from, e.g. a ZipfRandomVariable for a popularity "
+                   "skew. If unset, requests name no object and no cache "
+                   "keeps their responses.",
+                   PointerValue (),
+                   MakePointerAccessor (&TcpClientApplication::m_objectId),
+                   MakePointerChecker<RandomVariableStream> ())
+    .AddAttribute ("InterArrivalTime",
+                   "The random variable the seconds between two requests are "
+                   "drawn from, e.g. an ExponentialRandomVariable for Poisson "
+                   "arrivals. Requests are then issued as they arrive, "
+                   "whatever PipelineDepth. If unset, a request is issued as "
+                   "soon as fewer than PipelineDepth are outstanding.",
+                   PointerValue (),
+                   MakePointerAccessor (&TcpClientApplication::m_interArrival),
+                   MakePointerChecker<RandomVariableStream> ())
+    .AddAttribute ("OnTime",
+                   "The random variable the duration of the periods in which "
+                   "requests arrive is drawn from, in seconds. "
+                   "If unset, requests arrive all the time. An on period and "
+                   "the off period after it must not both be empty.",
+                   PointerValue (),
+                   MakePointerAccessor (&TcpClientApplication::m_onTime),
+                   MakePointerChecker<RandomVariableStream> ())
+    .AddAttribute ("OffTime",
+                   "The random variable the duration of the periods without "
+                   "arrivals between two on periods is drawn from, in seconds.",
+                   PointerValue (),
+                   MakePointerAccessor (&TcpClientApplication::m_offTime),
+                   MakePointerChecker<RandomVariableStream> ())
+    .AddAttribute ("ServerSelector",
+                   "The selector of a server pool. If set, the client asks "
+                   "it for its server when it starts, instead of using "
+                   "Remote, and keeps that server across reconnections.",
+                   PointerValue (),
+                   MakePointerAccessor (&TcpClientApplication::m_selector),
+                   MakePointerChecker<ServerSelector> ())
+    .AddAttribute ("RecreateSocket",
+                   "If true, StartConnection closes the socket and connects a "
+                   "new one, bound to the current address of the node, and "
+                   "failed or reset connections are retried. Otherwise the "
+                   "same socket connects again.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpClientApplication::m_recreateSocket),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MaxConnectAttempts",
+                   "The connection attempts after which a RecreateSocket "
+                   "client gives up. The value zero means that there is no limit.",
+                   UintegerValue (8),
+                   MakeUintegerAccessor (&TcpClientApplication::m_maxAttempts),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("ImmediateRetries",
+                   "The failed attempts retried at once, before backing off.",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&TcpClientApplication::m_immediateRetries),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("InitialBackoff",
+                   "The delay before the first backed off retry; "
+                   "it doubles with every further failure.",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&TcpClientApplication::m_initialBackoff),
+                   MakeTimeChecker ())
+    .AddAttribute ("MaxBackoff",
+                   "The largest delay between two retries.",
+                   TimeValue (Seconds (5)),
+                   MakeTimeAccessor (&TcpClientApplication::m_maxBackoff),
+                   MakeTimeChecker ())
+    .AddAttribute ("ConnTimeout",
+                   "The SYN retransmission timeout of the sockets of a "
+                   "RecreateSocket client.",
+                   TimeValue (Seconds (3)),
+                   MakeTimeAccessor (&TcpClientApplication::m_connTimeout),
+                   MakeTimeChecker ())
+    .AddAttribute ("ConnCount",
+                   "The SYN retransmissions of the sockets of a RecreateSocket "
+                   "client before the attempt fails.",
+                   UintegerValue (6),
+                   MakeUintegerAccessor (&TcpClientApplication::m_connCount),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("CongestionControl",
+                   "TypeId name of the TCP congestion control of the sockets, "
+                   "e.g. ns3::TcpCubic. Empty for the node's default.",
+                   StringValue (""),
+                   MakeStringAccessor (&TcpClientApplication::m_congestionControl),
+                   MakeStringChecker ())
+    .AddAttribute ("InitialCwnd",
+                   "Initial congestion window of the sockets, in segments. "
+                   "The value zero keeps the TcpSocket default.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&TcpClientApplication::m_initialCwnd),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("SndBufSize",
+                   "Tx buffer size of the sockets, in bytes. "
+                   "The value zero keeps the TcpSocket default.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&TcpClientApplication::m_sndBufSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("RcvBufSize",
+                   "Rx buffer size of the sockets, in bytes. "
+                   "The value zero keeps the TcpSocket default.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&TcpClientApplication::m_rcvBufSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("SegmentSize",
+                   "TCP maximum segment size of the sockets, in bytes. "
+                   "The value zero keeps the TcpSocket default.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&TcpClientApplication::m_segmentSize),
                    MakeUintegerChecker<uint32_t> ())
     .AddTraceSource ("Tx", "A new packet is created and is sent",
                      MakeTraceSourceAccessor (&TcpClientApplication::m_txTrace),
@@ -41,6 +190,20 @@ TcpClientApplication::GetTypeId (void)
                      "A packet has been received",
                      MakeTraceSourceAccessor (&TcpClientApplication::m_rxTrace),
                      "ns3::Packet::PacketAddressTracedCallback")
+    .AddTraceSource ("RxBatch",
+                     "The socket has been drained: bytes, packets, peer",
+                     MakeTraceSourceAccessor (&TcpClientApplication::m_rxBatchTrace),
+                     "ns3::TcpClientApplication::RxBatchTracedCallback")
+    .AddTraceSource ("TransferComplete",
+                     "A request has been fully answered: "
+                     "request id, bytes, time to first and to last byte",
+                     MakeTraceSourceAccessor (&TcpClientApplication::m_transferTrace),
+                     "ns3::TcpTransferStats::TransferTracedCallback")
+    .AddTraceSource ("Reconnect",
+                     "Data is received again after StartConnection: "
+                     "time since StartConnection, connection attempts",
+                     MakeTraceSourceAccessor (&TcpClientApplication::m_reconnectTrace),
+                     "ns3::TcpClientApplication::ReconnectTracedCallback")
   ;
   return tid;
 }
@@ -53,6 +216,14 @@ TcpClientApplication::TcpClientApplication ()
   NS_LOG_FUNCTION (this);
   m_totalRx = 0;
   m_completeRx = 0;
+  m_nextRequestId = 0;
+  m_completedRequests = 0;
+  m_resumedBytes = 0;
+  m_attempts = 0;
+  m_failedAttempts = 0;
+  m_reconnecting = false;
+  m_reconnections = 0;
+  m_server = 0;
 }
 
 TcpClientApplication::~TcpClientApplication ()
@@ -60,13 +231,13 @@ TcpClientApplication::~TcpClientApplication ()
   NS_LOG_FUNCTION (this);
 }
 
-uint32_t TcpClientApplication::GetTotalRx () const
+uint64_t TcpClientApplication::GetTotalRx () const
 {
   NS_LOG_FUNCTION (this);
   return m_totalRx;
 }
 
-uint32_t TcpClientApplication::GetCompleteRx () const
+uint64_t TcpClientApplication::GetCompleteRx () const
 {
   NS_LOG_FUNCTION (this);
   return m_completeRx;
@@ -79,11 +250,68 @@ TcpClientApplication::GetSocket (void) const
   return m_socket;
 }
 
+uint64_t TcpClientApplication::GetResumedBytes () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_resumedBytes;
+}
+
+uint32_t TcpClientApplication::GetCompletedRequests () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_completedRequests;
+}
+
+const TcpTransferStats &
+TcpClientApplication::GetStats () const
+{
+  return m_stats;
+}
+
+uint32_t TcpClientApplication::GetReconnections () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_reconnections;
+}
+
+Time TcpClientApplication::GetMeanReconnectLatency () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_reconnections > 0 ? m_reconnectLatencySum / static_cast<int64_t> (m_reconnections) : Time ();
+}
+
+uint32_t TcpClientApplication::GetFailedAttempts () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_failedAttempts;
+}
+
+int64_t
+TcpClientApplication::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  Ptr<RandomVariableStream> variables[5] = { m_objectSize, m_interArrival, m_onTime, m_offTime, m_objectId };
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      if (variables[i])
+        {
+          variables[i]->SetStream (stream + i);
+        }
+    }
+  return 5;
+}
+
 void
 TcpClientApplication::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
   m_socket = 0;
+  m_selector = 0;
+  m_objectSize = 0;
+  m_objectId = 0;
+  m_interArrival = 0;
+  m_onTime = 0;
+  m_offTime = 0;
   Application::DoDispose ();
 }
 
@@ -101,11 +329,24 @@ void TcpClientApplication::StartConnection (void)
 
   m_connected = false;
   m_totalRx = 0;
+  ResetRequests ();
 
   m_tid = TypeId::LookupByName ("ns3::TcpSocketFactory");
-  // Create the socket if not already
   if (m_socket)
+    { // time the reconnection up to its first byte
+      m_reconnecting = true;
+      m_reconnectStart = Simulator::Now ();
+      m_attempts = 0;
+      Simulator::Cancel (m_retryEvent);
+    }
+  if (m_socket && m_recreateSocket)
+    {
+      OpenSocket ();
+    }
+  // Create the socket if not already
+  else if (m_socket)
     {
+      m_attempts = 1;
       /*m_socket = Socket::CreateSocket (GetNode (), m_tid);
 
       // Fatal error if socket type is not NS3_SOCK_STREAM or NS3_SOCK_SEQPACKET
@@ -139,9 +380,32 @@ void TcpClientApplication::StartConnection (void)
 void TcpClientApplication::StartApplication (void) // Called at time specified by Start
 {
   NS_LOG_FUNCTION (this);
+  if (m_sessionId == 0)
+    {
+      // Derived from the node and the application index rather than a
+      // counter, so that every rank of a distributed run, and a sequential
+      // run, picks the same id
+      uint32_t index = 0;
+      while (index < GetNode ()->GetNApplications ()
+             && GetNode ()->GetApplication (index) != this)
+        {
+          index++;
+        }
+      m_sessionId = (GetNode ()->GetId () << 8) + index + 1;
+    }
+  if (m_selector && !m_socket)
+    { // a resumed session needs the server that has it
+      m_server = m_selector->Select (m_sessionId);
+      m_peer = m_selector->GetServer (m_server);
+    }
    m_tid = TypeId::LookupByName ("ns3::TcpSocketFactory");
   // Create the socket if not already
-  if (!m_socket)
+  if (!m_socket && m_recreateSocket)
+    {
+      m_attempts = 0;
+      OpenSocket ();
+    }
+  else if (!m_socket)
     {
       m_socket = Socket::CreateSocket (GetNode (), m_tid);
 
@@ -151,6 +415,8 @@ void TcpClientApplication::StartApplication (void) // Called at time specified b
         {
           NS_FATAL_ERROR ("Use TCP instead of UDP.");
         }
+      ConfigureTcpSocket (m_socket, m_congestionControl, m_initialCwnd,
+                          m_sndBufSize, m_rcvBufSize, m_segmentSize);
       /*if (InetSocketAddress::IsMatchingType (m_peer))
         {
           m_socket->Bind ();
@@ -164,6 +430,20 @@ void TcpClientApplication::StartApplication (void) // Called at time specified b
         MakeCallback (&TcpClientApplication::DataSend, this));
       m_socket->SetRecvCallback (
         MakeCallback (&TcpClientApplication::HandleRead, this));
+      m_socket->SetCloseCallbacks (
+        MakeCallback (&TcpClientApplication::PeerClosed, this),
+        MakeNullCallback<void, Ptr<Socket> > ());
+    }
+  if (m_interArrival)
+    {
+      if (m_onTime)
+        {
+          StartOnPeriod ();
+        }
+      else
+        {
+          ScheduleArrival ();
+        }
     }
   if (m_connected)
     {
@@ -174,6 +454,8 @@ void TcpClientApplication::StartApplication (void) // Called at time specified b
 void TcpClientApplication::StopApplication (void) // Called at time specified by Stop
 {
   NS_LOG_FUNCTION (this);
+  Simulator::Cancel (m_arrivalEvent);
+  Simulator::Cancel (m_retryEvent);
 
   if (m_socket != 0)
     {
@@ -193,43 +475,323 @@ void TcpClientApplication::SendData (void)
 {
   NS_LOG_FUNCTION (this);
 
-  if( m_totalRx == 0 )
-  {
-    NS_LOG_LOGIC ("sending packet at " << Simulator::Now ());
-    Ptr<Packet> packet = Create<Packet> (13);
-    m_txTrace (packet);
-    m_socket->Send (packet);
-    HandleRead(m_socket);
-  }
+  // Requests outstanding when the previous connection went away
+  for (std::deque<PendingRequest>::iterator it = m_requests.begin ();
+       it != m_requests.end (); ++it)
+    {
+      if (!it->sent && !SendRequest (*it))
+        {
+          return;
+        }
+    }
+  // With a workload, requests are only issued as they arrive
+  while (!m_interArrival && m_requests.size () < m_pipelineDepth
+         && (m_numRequests == 0 || m_nextRequestId < m_numRequests))
+    {
+      PendingRequest request;
+      request.id = m_nextRequestId++;
+      request.size = NextObjectSize ();
+      request.received = 0;
+      request.sent = false;
+      request.start = Simulator::Now ();
+      request.started = false;
+      request.objectId = m_objectId ? m_objectId->GetInteger () : 0;
+      m_requests.push_back (request);
+      if (m_selector)
+        {
+          m_selector->RequestStarted (m_server);
+        }
+      if (!SendRequest (m_requests.back ()))
+        {
+          return;
+        }
+    }
+  HandleRead(m_socket);
   
   //m_socket->Close ();
   //m_connected = false;
 }
 
+bool TcpClientApplication::SendRequest (PendingRequest &pending)
+{
+  NS_LOG_FUNCTION (this << pending.id);
+  TcpRequestHeader request;
+  request.SetSessionId (m_sessionId);
+  request.SetRequestId (pending.id);
+  request.SetObjectId (pending.objectId);
+  request.SetObjectSize (pending.size);
+  request.SetOffset (pending.received);
+  NS_LOG_LOGIC ("sending request " << request << " at " << Simulator::Now ());
+  Ptr<Packet> packet = Create<Packet> ();
+  packet->AddHeader (request);
+  m_txTrace (packet);
+  if (m_socket->Send (packet) <= 0)
+    { // DataSend tries again once the tx buffer has room
+      return false;
+    }
+  if (pending.received > 0)
+    {
+      NS_LOG_INFO ("Session " << m_sessionId << " resumes request " << pending.id
+                   << " at offset " << pending.received);
+      m_resumedBytes += pending.received;
+    }
+  pending.sent = true;
+  return true;
+}
+
+void TcpClientApplication::ResetRequests (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_resume)
+    { // ask the new connection for what is still missing
+      for (std::deque<PendingRequest>::iterator it = m_requests.begin ();
+           it != m_requests.end (); ++it)
+        {
+          it->sent = false;
+        }
+    }
+  else if (m_interArrival)
+    { // start the transfers over, keeping the requests that arrived
+      for (std::deque<PendingRequest>::iterator it = m_requests.begin ();
+           it != m_requests.end (); ++it)
+        {
+          it->sent = false;
+          it->received = 0;
+          it->started = false;
+        }
+    }
+  else
+    { // start the transfers over
+      for (uint32_t i = 0; m_selector && i < m_requests.size (); i++)
+        {
+          m_selector->RequestAbandoned (m_server);
+        }
+      m_requests.clear ();
+      m_nextRequestId = 0;
+    }
+}
+
+void TcpClientApplication::OpenSocket (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_socket)
+    {
+      // The old connection is bound to the old address; whatever still
+      // comes on it is of no use
+      m_socket->SetConnectCallback (MakeNullCallback<void, Ptr<Socket> > (),
+                                    MakeNullCallback<void, Ptr<Socket> > ());
+      m_socket->SetSendCallback (MakeNullCallback<void, Ptr<Socket>, uint32_t> ());
+      m_socket->SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
+      m_socket->SetCloseCallbacks (MakeNullCallback<void, Ptr<Socket> > (),
+                                   MakeNullCallback<void, Ptr<Socket> > ());
+      m_socket->Close ();
+    }
+  m_connected = false;
+  ++m_attempts;
+  m_socket = Socket::CreateSocket (GetNode (), m_tid);
+  if (m_socket->GetSocketType () != Socket::NS3_SOCK_STREAM &&
+      m_socket->GetSocketType () != Socket::NS3_SOCK_SEQPACKET)
+    {
+      NS_FATAL_ERROR ("Use TCP instead of UDP.");
+    }
+  m_socket->SetAttribute ("ConnTimeout", TimeValue (m_connTimeout));
+  m_socket->SetAttribute ("ConnCount", UintegerValue (m_connCount));
+  ConfigureTcpSocket (m_socket, m_congestionControl, m_initialCwnd,
+                      m_sndBufSize, m_rcvBufSize, m_segmentSize);
+  // Bound to no address in particular, the socket takes the source
+  // address of the route to the peer, i.e. the current one
+  m_socket->Bind ();
+  m_socket->Connect (m_peer);
+  m_socket->SetConnectCallback (
+    MakeCallback (&TcpClientApplication::ConnectionSucceeded, this),
+    MakeCallback (&TcpClientApplication::ConnectionFailed, this));
+  m_socket->SetSendCallback (
+    MakeCallback (&TcpClientApplication::DataSend, this));
+  m_socket->SetRecvCallback (
+    MakeCallback (&TcpClientApplication::HandleRead, this));
+  m_socket->SetCloseCallbacks (
+    MakeCallback (&TcpClientApplication::PeerClosed, this),
+    MakeCallback (&TcpClientApplication::ConnectionError, this));
+  NS_LOG_INFO ("Session " << m_sessionId << " connection attempt " << m_attempts
+               << " at " << Simulator::Now ().GetSeconds () << "s");
+}
+
+void TcpClientApplication::RetryConnection (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_maxAttempts > 0 && m_attempts >= m_maxAttempts)
+    {
+      NS_LOG_WARN ("Session " << m_sessionId << " gives up after "
+                   << m_attempts << " connection attempts");
+      return;
+    }
+  Time delay;
+  if (m_attempts > m_immediateRetries)
+    {
+      uint32_t backoffs = std::min<uint32_t> (m_attempts - m_immediateRetries - 1, 30);
+      delay = Min (m_initialBackoff * static_cast<int64_t> (1 << backoffs), m_maxBackoff);
+    }
+  // Not from within the callback of the failed socket
+  m_retryEvent = Simulator::Schedule (delay, &TcpClientApplication::OpenSocket, this);
+}
+
+uint64_t TcpClientApplication::NextObjectSize (void)
+{
+  if (!m_objectSize)
+    {
+      return m_maxRx;
+    }
+  // A size of zero would ask for the server's MaxTxBytes instead
+  double size = m_objectSize->GetValue ();
+  return size < 1 ? 1 : static_cast<uint64_t> (size + 0.5);
+}
+
+void TcpClientApplication::StartOnPeriod (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_onEnd = Simulator::Now () + Seconds (m_onTime->GetValue ());
+  ScheduleArrival ();
+}
+
+void TcpClientApplication::ScheduleArrival (void)
+{
+  NS_LOG_FUNCTION (this);
+  Time gap = Seconds (m_interArrival->GetValue ());
+  if (m_onTime && Simulator::Now () + gap >= m_onEnd)
+    {
+      // Arrivals are memoryless, so the next period simply draws afresh
+      Time off = m_offTime ? Seconds (m_offTime->GetValue ()) : Time ();
+      Time delay = m_onEnd - Simulator::Now () + off;
+      if (!delay.IsStrictlyPositive ())
+        { // otherwise the periods would follow each other at the same time forever
+          NS_FATAL_ERROR ("Session " << m_sessionId << " drew an on period and an off period "
+                          << "of no duration at " << Simulator::Now ().GetSeconds ()
+                          << "s; OnTime or OffTime must be positive");
+        }
+      m_arrivalEvent = Simulator::Schedule (delay,
+                                            &TcpClientApplication::StartOnPeriod, this);
+      return;
+    }
+  m_arrivalEvent = Simulator::Schedule (gap, &TcpClientApplication::Arrive, this);
+}
+
+void TcpClientApplication::Arrive (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_numRequests > 0 && m_nextRequestId >= m_numRequests)
+    {
+      return;
+    }
+  PendingRequest request;
+  request.id = m_nextRequestId++;
+  request.size = NextObjectSize ();
+  request.received = 0;
+  request.sent = false;
+  request.start = Simulator::Now ();
+  request.started = false;
+  request.objectId = m_objectId ? m_objectId->GetInteger () : 0;
+  m_requests.push_back (request);
+  if (m_selector)
+    {
+      m_selector->RequestStarted (m_server);
+    }
+  NS_LOG_LOGIC ("request " << request.id << " of " << request.size << " bytes arrived, "
+                << m_requests.size () << " outstanding");
+  if (m_connected)
+    {
+      SendData ();
+    }
+  ScheduleArrival ();
+}
+
 void TcpClientApplication::HandleRead (Ptr<Socket> socket)
 {
   NS_LOG_FUNCTION (this << socket);
   Ptr<Packet> packet;
   Address from;
+  uint32_t bytes = 0;
+  uint32_t packets = 0;
+  // Drain the socket first and account for the whole batch at once;
+  // per-packet tracing is only paid for when someone listens.
   while ((packet = socket->RecvFrom (from)))
     {
-      if (packet->GetSize () == 0)
+      uint32_t size = packet->GetSize ();
+      if (size == 0)
         { //EOF
           break;
         }
-      m_totalRx += packet->GetSize ();
-      m_completeRx += packet->GetSize ();
-      if (InetSocketAddress::IsMatchingType (from))
+      bytes += size;
+      ++packets;
+      if (!m_rxTrace.IsEmpty ())
+        {
+          m_rxTrace (packet, from);
+        }
+    }
+  if (packets == 0)
+    {
+      return;
+    }
+  m_totalRx += bytes;
+  m_completeRx += bytes;
+  if (InetSocketAddress::IsMatchingType (from))
+    {
+      NS_LOG_INFO ("At time " << Simulator::Now ().GetSeconds ()
+                   << "s packet sink received "
+                   << bytes << " bytes in " << packets << " packets from "
+                   << InetSocketAddress::ConvertFrom(from).GetIpv4 ()
+                   << " port " << InetSocketAddress::ConvertFrom (from).GetPort ()
+                   << " total Rx " << m_totalRx << " bytes");
+    }
+  m_rxBatchTrace (bytes, packets, from);
+  if (m_reconnecting)
+    {
+      m_reconnecting = false;
+      Time latency = Simulator::Now () - m_reconnectStart;
+      ++m_reconnections;
+      m_reconnectLatencySum += latency;
+      NS_LOG_INFO ("Session " << m_sessionId << " receives again " << latency.GetSeconds ()
+                   << "s after reconnecting, in " << m_attempts << " attempts");
+      m_reconnectTrace (latency, m_attempts);
+    }
+
+  // Responses come back in request order
+  bool completed = false;
+  while (bytes > 0 && !m_requests.empty ())
+    {
+      PendingRequest &request = m_requests.front ();
+      if (!request.started)
+        {
+          request.firstByte = Simulator::Now ();
+          request.started = true;
+        }
+      if (request.size == 0)
+        {
+          request.received += bytes;
+          break;
+        }
+      uint32_t part = static_cast<uint32_t> (std::min<uint64_t> (bytes, request.size - request.received));
+      request.received += part;
+      bytes -= part;
+      if (request.received == request.size)
         {
-          NS_LOG_INFO ("At time " << Simulator::Now ().GetSeconds ()
-                       << "s packet sink received "
-                       <<  packet->GetSize () << " bytes from "
-                       << InetSocketAddress::ConvertFrom(from).GetIpv4 ()
-                       << " port " << InetSocketAddress::ConvertFrom (from).GetPort ()
-                       << " total Rx " << m_totalRx << " bytes");
+          NS_LOG_INFO ("Request " << request.id << " of session " << m_sessionId
+                       << " complete at " << Simulator::Now ().GetSeconds () << "s");
+          Time firstByte = request.firstByte - request.start;
+          Time completion = Simulator::Now () - request.start;
+          m_stats.Add (request.size, firstByte, completion);
+          m_transferTrace (request.id, request.size, firstByte, completion);
+          ++m_completedRequests;
+          if (m_selector)
+            {
+              m_selector->RequestCompleted (m_server, request.size);
+            }
+          m_requests.pop_front ();
+          completed = true;
         }
-      m_rxTrace (packet, from);
-      //socket->SendTo(packet, 0, from);
+    }
+  if (completed && m_connected)
+    {
+      SendData ();
     }
 }
 
@@ -245,6 +807,48 @@ void TcpClientApplication::ConnectionFailed (Ptr<Socket> socket)
 {
   NS_LOG_FUNCTION (this << socket);
   NS_LOG_LOGIC ("TcpClientApplication, Connection Failed");
+  if (m_recreateSocket && socket == m_socket)
+    {
+      ++m_failedAttempts;
+      RetryConnection ();
+    }
+}
+
+void TcpClientApplication::PeerClosed (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  if (socket != m_socket)
+    {
+      return;
+    }
+  NS_LOG_INFO ("Session " << m_sessionId << " closed by the server at "
+               << Simulator::Now ().GetSeconds () << "s, "
+               << m_requests.size () << " requests outstanding");
+  // A non-persistent server closes once it has answered, and keeps the
+  // connection counted until we close our side
+  m_connected = false;
+  socket->Close ();
+}
+
+void TcpClientApplication::ConnectionError (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  if (socket != m_socket || !m_connected)
+    { // a failed attempt is ConnectionFailed's
+      return;
+    }
+  NS_LOG_INFO ("Session " << m_sessionId << " connection reset at "
+               << Simulator::Now ().GetSeconds () << "s");
+  m_connected = false;
+  m_totalRx = 0;
+  ResetRequests ();
+  if (!m_reconnecting)
+    {
+      m_reconnecting = true;
+      m_reconnectStart = Simulator::Now ();
+    }
+  m_attempts = 0;
+  RetryConnection ();
 }
 
 void TcpClientApplication::DataSend (Ptr<Socket>, uint32_t)
@@ -5,15 +5,19 @@
 #include "ns3/application.h"
 #include "ns3/event-id.h"
 #include "ns3/ptr.h"
+#include "ns3/random-variable-stream.h"
 #include "ns3/traced-callback.h"
 
 #include <stdint.h>
 #include <string>
+#include <deque>
 //#include "ns3/object-factory.h"
 #include "ns3/attribute.h"
 #include "ns3/net-device.h"
 #include "ns3/node-container.h"
 #include "ns3/application-container.h"
+#include "tcp-transfer-stats.h"
+#include "server-pool.h"
 
 namespace ns3 {
 
@@ -34,6 +38,25 @@ public:
    */
   static TypeId GetTypeId (void);
 
+  /**
+   * TracedCallback signature for a drained batch of received data.
+   *
+   * \param [in] bytes the number of bytes drained
+   * \param [in] packets the number of packets drained
+   * \param [in] peer the address the data came from
+   */
+  typedef void (* RxBatchTracedCallback)
+    (uint32_t bytes, uint32_t packets, const Address &peer);
+
+  /**
+   * TracedCallback signature for a completed reconnection.
+   *
+   * \param [in] latency the time from StartConnection to the first byte
+   *             received on the new connection
+   * \param [in] attempts the connection attempts it took
+   */
+  typedef void (* ReconnectTracedCallback) (Time latency, uint32_t attempts);
+
   TcpClientApplication ();
 
   virtual ~TcpClientApplication ();
@@ -41,19 +64,60 @@ public:
   /**
    * \return the total bytes received in this sink app at current session
    */
-  uint32_t GetTotalRx () const;
+  uint64_t GetTotalRx () const;
   /**
    * \return the complete bytes received in this sink app at sim end
    */
-  uint32_t GetCompleteRx () const;
+  uint64_t GetCompleteRx () const;
   /**
    * \brief Get the socket this application is attached to.
    * \return pointer to associated socket
    */
   Ptr<Socket> GetSocket (void) const;
+  /**
+   * \return the bytes the client did not request again because it
+   * resumed a transfer after reconnecting
+   */
+  uint64_t GetResumedBytes () const;
+  /**
+   * \return the number of requests fully answered
+   */
+  uint32_t GetCompletedRequests () const;
+  /**
+   * \return the statistics of the completed requests
+   */
+  const TcpTransferStats &GetStats () const;
+  /**
+   * \return the number of reconnections that received data again
+   */
+  uint32_t GetReconnections () const;
+  /**
+   * \return the mean time from StartConnection to the first byte received
+   * on the new connection
+   */
+  Time GetMeanReconnectLatency () const;
+  /**
+   * \return the connection attempts that failed
+   */
+  uint32_t GetFailedAttempts () const;
 
+  /**
+   * \brief Connect again, e.g. after the address of the node changed.
+   *
+   * With the Resume attribute set, the new request carries the number of
+   * bytes already received so the server only sends the rest. With
+   * RecreateSocket set, the old socket is closed and a new one, bound to
+   * the current address of the node, connects instead.
+   */
   void StartConnection(void);
 
+  /**
+   * \brief Use fixed random variable streams for the workload.
+   * \param stream the first stream index to use
+   * \return the number of stream indices used
+   */
+  int64_t AssignStreams (int64_t stream);
+
 protected:
   virtual void DoDispose (void);
 private:
@@ -62,23 +126,129 @@ private:
   virtual void StopApplication (void);     // Called at time specified by Stop
 
   void HandleRead (Ptr<Socket> socket);
+  /// A request issued by the client and not fully answered yet.
+  struct PendingRequest
+  {
+    uint32_t id;        //!< Request id
+    uint64_t size;      //!< Expected response size, 0 if unknown
+    uint64_t received;  //!< Response bytes received so far
+    bool     sent;      //!< True once sent on the current connection
+    Time     start;     //!< Time the request was first issued
+    Time     firstByte; //!< Time the first byte of the response arrived
+    bool     started;   //!< True once the first byte arrived
+    uint32_t objectId;  //!< Id of the requested object, 0 for none
+  };
+
   /**
-   * \brief Send data until the L4 transmission buffer is full.
+   * \brief Send the requests not sent on this connection yet, then issue
+   * new ones until PipelineDepth requests are outstanding.
    */
   void SendData ();
+  /**
+   * \brief Send one request on the socket.
+   * \param request the request
+   * \return false if the tx buffer could not take it
+   */
+  bool SendRequest (PendingRequest &request);
+  /**
+   * \return the size of a new request, drawn from ObjectSize if set
+   */
+  uint64_t NextObjectSize (void);
+  /**
+   * \brief Start a period in which requests arrive.
+   */
+  void StartOnPeriod (void);
+  /**
+   * \brief Schedule the next request arrival, or the next on period if
+   * the arrival would fall after the end of this one.
+   */
+  void ScheduleArrival (void);
+  /**
+   * \brief Issue a request of the workload and schedule the next one.
+   */
+  void Arrive (void);
+  /**
+   * \brief Mark the outstanding requests as not sent, to send them again
+   * on a new connection.
+   */
+  void ResetRequests (void);
+  /**
+   * \brief Close the socket, if any, and connect a new one.
+   */
+  void OpenSocket (void);
+  /**
+   * \brief Open a new socket after an immediate retry or a backoff, unless
+   * MaxConnectAttempts attempts failed.
+   */
+  void RetryConnection (void);
+  /**
+   * \brief The connection was reset (called by Socket through a callback)
+   * \param socket the socket
+   */
+  void ConnectionError (Ptr<Socket> socket);
+  /**
+   * \brief The server closed the connection (called by Socket through a
+   * callback); close our side too, so that the server can let it go.
+   * \param socket the socket
+   */
+  void PeerClosed (Ptr<Socket> socket);
 
   Ptr<Socket>     m_socket;       //!< Associated socket
   Address         m_peer;         //!< Peer address
   bool            m_connected;    //!< True if connected
   uint32_t        m_sendSize;     //!< Size of data to send each time
-  uint32_t        m_totalRx;      //!< Total bytes received
-  uint32_t        m_completeRx;      //!< Total bytes received
-  uint32_t        m_maxRx;      //!< Total bytes received
+  uint64_t        m_totalRx;      //!< Bytes received on the current connection
+  uint64_t        m_completeRx;   //!< Bytes received on all connections
+  uint64_t        m_maxRx;        //!< Size of each requested object
   TypeId          m_tid;          //!< The type of protocol to use.
+  bool            m_resume;       //!< Resume the transfer after reconnecting
+  uint32_t        m_sessionId;    //!< Session id sent in requests
+  uint32_t        m_numRequests;  //!< Requests to issue, 0 for no limit
+  uint32_t        m_pipelineDepth; //!< Maximum outstanding requests
+  uint32_t        m_nextRequestId; //!< Id of the next new request
+  uint32_t        m_completedRequests; //!< Requests fully answered
+  std::deque<PendingRequest> m_requests; //!< Outstanding requests, in order
+  uint64_t        m_resumedBytes; //!< Bytes not requested again on reconnection
+  Ptr<RandomVariableStream> m_objectSize;  //!< Sizes of the requested objects
+  Ptr<RandomVariableStream> m_objectId;    //!< Ids of the requested objects
+  Ptr<RandomVariableStream> m_interArrival; //!< Seconds between request arrivals
+  Ptr<RandomVariableStream> m_onTime;      //!< Duration of the on periods
+  Ptr<RandomVariableStream> m_offTime;     //!< Duration of the off periods
+  EventId         m_arrivalEvent; //!< Next request arrival or on period
+  Time            m_onEnd;        //!< End of the current on period
+  bool            m_recreateSocket; //!< Reconnect on a new socket
+  uint32_t        m_maxAttempts;  //!< Connection attempts before giving up, 0 for no limit
+  uint32_t        m_immediateRetries; //!< Retries without backoff
+  Time            m_initialBackoff; //!< Delay of the first backed off retry
+  Time            m_maxBackoff;   //!< Largest delay between retries
+  Time            m_connTimeout;  //!< SYN retransmission timeout of new sockets
+  uint32_t        m_connCount;    //!< SYN retransmissions of new sockets
+  std::string     m_congestionControl; //!< Congestion control of the sockets, empty for the default
+  uint32_t        m_initialCwnd;  //!< Initial cwnd of the sockets in segments, 0 for the default
+  uint32_t        m_sndBufSize;   //!< Tx buffer size of the sockets, 0 for the default
+  uint32_t        m_rcvBufSize;   //!< Rx buffer size of the sockets, 0 for the default
+  uint32_t        m_segmentSize;  //!< Segment size of the sockets, 0 for the default
+  EventId         m_retryEvent;   //!< Next connection attempt
+  uint32_t        m_attempts;     //!< Connection attempts since StartConnection
+  uint32_t        m_failedAttempts; //!< Connection attempts that failed
+  bool            m_reconnecting; //!< True until a reconnection receives data
+  Time            m_reconnectStart; //!< Time of the last StartConnection
+  uint32_t        m_reconnections; //!< Reconnections that received data
+  Time            m_reconnectLatencySum; //!< Sum of their latencies
+  Ptr<ServerSelector> m_selector; //!< Picks the server instead of Remote
+  uint32_t        m_server;       //!< Index of the server in m_selector
 
   /// Traced Callback: sent packets
   TracedCallback<Ptr<const Packet> > m_txTrace;
   TracedCallback<Ptr<const Packet>, const Address &> m_rxTrace;
+  /// Traced Callback: bytes and packets drained by one HandleRead, source address.
+  TracedCallback<uint32_t, uint32_t, const Address &> m_rxBatchTrace;
+  /// Traced Callback: a request has been fully answered.
+  TracedCallback<uint32_t, uint64_t, Time, Time> m_transferTrace;
+  /// Traced Callback: data is received again after a reconnection.
+  TracedCallback<Time, uint32_t> m_reconnectTrace;
+
+  TcpTransferStats m_stats;       //!< Statistics of the completed requests
 
 private:
   /**
@@ -0,0 +1,302 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "tcp-client-server-benchmark.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpClientServerBenchmark");
+
+namespace {
+
+void
+SetClients (ScenarioConfig &config, const std::string &value)
+{
+  config.numClients = std::strtoul (value.c_str (), 0, 10);
+}
+
+void
+SetSendSize (ScenarioConfig &config, const std::string &value)
+{
+  config.sendSize = std::strtoul (value.c_str (), 0, 10);
+}
+
+void
+SetMaxBytes (ScenarioConfig &config, const std::string &value)
+{
+  config.maxBytes = std::strtoull (value.c_str (), 0, 10);
+}
+
+void
+SetRate (ScenarioConfig &config, const std::string &value)
+{
+  config.accessRate = value;
+  config.bottleneckRate = value;
+}
+
+void
+SetCongestionControl (ScenarioConfig &config, const std::string &value)
+{
+  config.congestionControl = value;
+}
+
+void
+SetInitialCwnd (ScenarioConfig &config, const std::string &value)
+{
+  config.initialCwnd = std::strtoul (value.c_str (), 0, 10);
+}
+
+void
+SetBufferSize (ScenarioConfig &config, const std::string &value)
+{
+  config.sndBufSize = std::strtoul (value.c_str (), 0, 10);
+  config.rcvBufSize = config.sndBufSize;
+}
+
+void
+SetSegmentSize (ScenarioConfig &config, const std::string &value)
+{
+  config.segmentSize = std::strtoul (value.c_str (), 0, 10);
+}
+
+} // anonymous namespace
+
+TcpClientServerBenchmark::TcpClientServerBenchmark ()
+  : m_enabled (false),
+    m_clients ("2,8,32"),
+    m_format ("csv"),
+    m_jobs (1)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+TcpClientServerBenchmark::AddOptions (CommandLine &cmd)
+{
+  NS_LOG_FUNCTION (this);
+  cmd.AddValue ("bench",
+                "Run the simulation throughput benchmark and exit", m_enabled);
+  cmd.AddValue ("benchClients",
+                "Comma separated client counts swept by the benchmark", m_clients);
+  cmd.AddValue ("benchSendSizes",
+                "Comma separated server SendSize values swept by the benchmark "
+                "(default: sendSize)", m_sendSizes);
+  cmd.AddValue ("benchMaxBytes",
+                "Comma separated transfer sizes swept by the benchmark "
+                "(default: maxBytes)", m_maxBytes);
+  cmd.AddValue ("benchRates",
+                "Comma separated rates of all links swept by the benchmark "
+                "(default: accessRate and bottleneckRate)", m_rates);
+  cmd.AddValue ("benchCongestionControls",
+                "Comma separated TCP congestion controls swept by the benchmark, "
+                "e.g. TcpNewReno,TcpCubic,TcpBbr (default: congestionControl)",
+                m_congestionControls);
+  cmd.AddValue ("benchInitialCwnds",
+                "Comma separated initial congestion windows, in segments, swept by "
+                "the benchmark (default: initialCwnd)", m_initialCwnds);
+  cmd.AddValue ("benchBufferSizes",
+                "Comma separated socket tx and rx buffer sizes swept by the benchmark "
+                "(default: sndBufSize and rcvBufSize)", m_bufferSizes);
+  cmd.AddValue ("benchSegmentSizes",
+                "Comma separated TCP segment sizes swept by the benchmark "
+                "(default: segmentSize)", m_segmentSizes);
+  cmd.AddValue ("benchFormat", "Benchmark report format: csv or json", m_format);
+  cmd.AddValue ("benchOutput",
+                "Benchmark report file (default: standard output)", m_output);
+  cmd.AddValue ("benchJobs",
+                "Benchmark runs at once, 0 for one per CPU", m_jobs);
+}
+
+bool
+TcpClientServerBenchmark::IsEnabled (void) const
+{
+  return m_enabled;
+}
+
+int
+TcpClientServerBenchmark::Run (const ScenarioConfig &base)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_format != "csv" && m_format != "json")
+    {
+      std::cerr << "Unknown benchmark format " << m_format << std::endl;
+      return 1;
+    }
+
+  std::vector<ScenarioConfig> configs = Expand (base);
+  std::vector<ScenarioResult> results;
+  std::vector<bool> ok;
+  ScenarioWorkerPool pool;
+  pool.SetJobs (m_jobs);
+  pool.Run (configs, results, ok);
+
+  std::vector<Row> rows;
+  bool failed = false;
+  for (uint32_t i = 0; i < configs.size (); i++)
+    {
+      Row row;
+      row.config = configs[i];
+      row.result = results[i];
+      row.ok = ok[i];
+      failed |= !row.ok;
+      rows.push_back (row);
+    }
+
+  std::ofstream file;
+  if (!m_output.empty ())
+    {
+      file.open (m_output.c_str ());
+      if (!file)
+        {
+          std::cerr << "Cannot open " << m_output << std::endl;
+          return 1;
+        }
+    }
+  std::ostream &os = m_output.empty () ? std::cout : file;
+  if (m_format == "json")
+    {
+      WriteJson (os, rows);
+    }
+  else
+    {
+      WriteCsv (os, rows);
+    }
+  return failed ? 1 : 0;
+}
+
+std::vector<ScenarioConfig>
+TcpClientServerBenchmark::Expand (const ScenarioConfig &base) const
+{
+  ScenarioConfig config = base;
+  config.tracing = "none";
+  config.quiet = true;
+
+  // The first parameter varies slowest
+  std::vector<ScenarioConfig> configs (1, config);
+  Multiply (configs, m_clients, &SetClients);
+  Multiply (configs, m_sendSizes, &SetSendSize);
+  Multiply (configs, m_maxBytes, &SetMaxBytes);
+  Multiply (configs, m_rates, &SetRate);
+  Multiply (configs, m_congestionControls, &SetCongestionControl);
+  Multiply (configs, m_initialCwnds, &SetInitialCwnd);
+  Multiply (configs, m_bufferSizes, &SetBufferSize);
+  Multiply (configs, m_segmentSizes, &SetSegmentSize);
+  return configs;
+}
+
+void
+TcpClientServerBenchmark::Multiply (std::vector<ScenarioConfig> &configs,
+                                    const std::string &list, Setter set)
+{
+  // An empty list keeps the value of the base configuration
+  std::vector<std::string> values = Split (list);
+  if (values.empty ())
+    {
+      return;
+    }
+  std::vector<ScenarioConfig> expanded;
+  expanded.reserve (configs.size () * values.size ());
+  for (uint32_t i = 0; i < configs.size (); i++)
+    {
+      for (uint32_t v = 0; v < values.size (); v++)
+        {
+          expanded.push_back (configs[i]);
+          set (expanded.back (), values[v]);
+        }
+    }
+  configs.swap (expanded);
+}
+
+void
+TcpClientServerBenchmark::WriteCsv (std::ostream &os, const std::vector<Row> &rows)
+{
+  os << "clients,sendSize,maxBytes,rate,congestionControl,initialCwnd,sndBufSize,"
+     << "rcvBufSize,segmentSize,ok,wallSeconds,events,eventsPerSecond,"
+     << "peakRssKb,bytesReceived,simulatedBytesPerSecond,completedRequests,"
+     << "serverSendCalls,meanGoodput,completionP50,completionP99" << std::endl;
+  for (uint32_t i = 0; i < rows.size (); i++)
+    {
+      const ScenarioConfig &c = rows[i].config;
+      const ScenarioResult &r = rows[i].result;
+      os << c.numClients << "," << c.sendSize << "," << c.maxBytes << ","
+         << c.bottleneckRate << ","
+         << (c.congestionControl.empty () ? "default" : c.congestionControl) << ","
+         << c.initialCwnd << "," << c.sndBufSize << "," << c.rcvBufSize << ","
+         << c.segmentSize << "," << rows[i].ok;
+      if (rows[i].ok)
+        {
+          os << "," << r.wallSeconds << "," << r.events << ","
+             << r.events / r.wallSeconds << "," << r.peakRssKb << ","
+             << r.bytesReceived << "," << r.bytesReceived / r.wallSeconds << ","
+             << r.completedRequests << "," << r.serverSendCalls << ","
+             << r.meanGoodput << "," << r.completionP50 << "," << r.completionP99;
+        }
+      else
+        {
+          os << ",,,,,,,,,,,";
+        }
+      os << std::endl;
+    }
+}
+
+void
+TcpClientServerBenchmark::WriteJson (std::ostream &os, const std::vector<Row> &rows)
+{
+  os << "[" << std::endl;
+  for (uint32_t i = 0; i < rows.size (); i++)
+    {
+      const ScenarioConfig &c = rows[i].config;
+      const ScenarioResult &r = rows[i].result;
+      os << "  {\"clients\": " << c.numClients
+         << ", \"sendSize\": " << c.sendSize
+         << ", \"maxBytes\": " << c.maxBytes
+         << ", \"rate\": \"" << c.bottleneckRate << "\""
+         << ", \"congestionControl\": \""
+         << (c.congestionControl.empty () ? "default" : c.congestionControl) << "\""
+         << ", \"initialCwnd\": " << c.initialCwnd
+         << ", \"sndBufSize\": " << c.sndBufSize
+         << ", \"rcvBufSize\": " << c.rcvBufSize
+         << ", \"segmentSize\": " << c.segmentSize
+         << ", \"ok\": " << (rows[i].ok ? "true" : "false");
+      if (rows[i].ok)
+        {
+          os << ", \"wallSeconds\": " << r.wallSeconds
+             << ", \"events\": " << r.events
+             << ", \"eventsPerSecond\": " << r.events / r.wallSeconds
+             << ", \"peakRssKb\": " << r.peakRssKb
+             << ", \"bytesReceived\": " << r.bytesReceived
+             << ", \"simulatedBytesPerSecond\": " << r.bytesReceived / r.wallSeconds
+             << ", \"completedRequests\": " << r.completedRequests
+             << ", \"serverSendCalls\": " << r.serverSendCalls
+             << ", \"meanGoodput\": " << r.meanGoodput
+             << ", \"completionP50\": " << r.completionP50
+             << ", \"completionP99\": " << r.completionP99;
+        }
+      os << "}" << (i + 1 < rows.size () ? "," : "") << std::endl;
+    }
+  os << "]" << std::endl;
+}
+
+std::vector<std::string>
+TcpClientServerBenchmark::Split (const std::string &list)
+{
+  std::vector<std::string> values;
+  std::istringstream is (list);
+  std::string value;
+  while (std::getline (is, value, ','))
+    {
+      if (!value.empty ())
+        {
+          values.push_back (value);
+        }
+    }
+  return values;
+}
+
+} // namespace ns3
@@ -0,0 +1,114 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef TCP_CLIENT_SERVER_BENCHMARK_H
+#define TCP_CLIENT_SERVER_BENCHMARK_H
+
+#include "tcp-client-server.h"
+#include "scenario-worker-pool.h"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief Measures how fast the tcp-client-server scenario simulates.
+ *
+ * Sweeps the number of clients, the server SendSize, the transfer size,
+ * the link rate and the TCP settings of the sockets (congestion control,
+ * initial window, buffer sizes and segment size), and reports wall-clock
+ * time, simulator events, peak RSS, simulated bytes per wall-clock second
+ * and the goodput and completion times of every combination as CSV or
+ * JSON.
+ *
+ * Each combination runs in a child process of its own, so that the peak
+ * RSS of one run is not inflated by the ones before it and a crash only
+ * loses one row.  The runs are sequential unless --benchJobs says
+ * otherwise, as concurrent runs skew each other's wall-clock times.
+ * Tracing is forced off.
+ */
+class TcpClientServerBenchmark
+{
+public:
+  TcpClientServerBenchmark ();
+
+  /**
+   * \brief Register the benchmark options on a command line.
+   * \param cmd the command line
+   */
+  void AddOptions (CommandLine &cmd);
+
+  /**
+   * \return true if the benchmark was asked for on the command line
+   */
+  bool IsEnabled (void) const;
+
+  /**
+   * \brief Run every combination of the sweep and write the report.
+   * \param base the parameters not swept
+   * \return the exit status of the program
+   */
+  int Run (const ScenarioConfig &base);
+
+  /**
+   * \param list comma separated values
+   * \return the values, as strings
+   */
+  static std::vector<std::string> Split (const std::string &list);
+
+private:
+  /// One row of the report
+  struct Row
+  {
+    ScenarioConfig config; //!< Parameters of the run
+    ScenarioResult result; //!< Results of the run
+    bool ok;               //!< The run completed
+  };
+
+  /**
+   * \param base the parameters not swept
+   * \return every combination of the swept parameters
+   */
+  std::vector<ScenarioConfig> Expand (const ScenarioConfig &base) const;
+
+  /// Sets one swept parameter of a configuration from its text
+  typedef void (* Setter) (ScenarioConfig &config, const std::string &value);
+
+  /**
+   * \brief Replace every configuration by one per value of a parameter.
+   * \param configs the configurations, in order
+   * \param list comma separated values, empty to keep the configurations
+   * \param set sets the parameter
+   */
+  static void Multiply (std::vector<ScenarioConfig> &configs,
+                        const std::string &list, Setter set);
+
+  /**
+   * \param os the output stream
+   * \param rows the rows of the report
+   */
+  static void WriteCsv (std::ostream &os, const std::vector<Row> &rows);
+  /**
+   * \param os the output stream
+   * \param rows the rows of the report
+   */
+  static void WriteJson (std::ostream &os, const std::vector<Row> &rows);
+
+  bool        m_enabled;   //!< Run the benchmark instead of the scenario
+  std::string m_clients;   //!< Client counts to sweep
+  std::string m_sendSizes; //!< Server SendSize values to sweep
+  std::string m_maxBytes;  //!< Transfer sizes to sweep
+  std::string m_rates;     //!< Link rates to sweep
+  std::string m_congestionControls; //!< Congestion controls to sweep
+  std::string m_initialCwnds; //!< Initial windows to sweep
+  std::string m_bufferSizes; //!< Socket buffer sizes to sweep
+  std::string m_segmentSizes; //!< Segment sizes to sweep
+  std::string m_format;    //!< csv or json
+  std::string m_output;    //!< Report file, standard output if empty
+  uint32_t    m_jobs;      //!< Concurrent runs, 0 for one per CPU
+};
+
+} // namespace ns3
+
+#endif /* TCP_CLIENT_SERVER_BENCHMARK_H */
@@ -0,0 +1,207 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "tcp-client-server-sweep.h"
+#include "tcp-client-server-benchmark.h"
+#include "scenario-worker-pool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpClientServerSweep");
+
+TcpClientServerSweep::Summary::Summary ()
+  : m_n (0),
+    m_sum (0),
+    m_sum2 (0)
+{
+}
+
+void
+TcpClientServerSweep::Summary::Add (double value)
+{
+  m_n++;
+  m_sum += value;
+  m_sum2 += value * value;
+}
+
+double
+TcpClientServerSweep::Summary::GetMean (void) const
+{
+  return m_n > 0 ? m_sum / m_n : 0;
+}
+
+double
+TcpClientServerSweep::Summary::GetStdDev (void) const
+{
+  if (m_n < 2)
+    {
+      return 0;
+    }
+  double variance = (m_sum2 - m_sum * m_sum / m_n) / (m_n - 1);
+  return variance > 0 ? std::sqrt (variance) : 0;
+}
+
+TcpClientServerSweep::TcpClientServerSweep ()
+  : m_enabled (false),
+    m_runs (1),
+    m_jobs (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+TcpClientServerSweep::AddOptions (CommandLine &cmd)
+{
+  NS_LOG_FUNCTION (this);
+  cmd.AddValue ("sweep",
+                "Run a parameter sweep in parallel and exit", m_enabled);
+  cmd.AddValue ("sweepFirstIPchange",
+                "Comma separated firstIPchange values swept (default: firstIPchange)",
+                m_firstIPchange);
+  cmd.AddValue ("sweepMaxBytes",
+                "Comma separated transfer sizes swept (default: maxBytes)", m_maxBytes);
+  cmd.AddValue ("sweepClients",
+                "Comma separated client counts swept (default: numClients)", m_clients);
+  cmd.AddValue ("sweepRuns",
+                "Seeds per combination, as run numbers from run on", m_runs);
+  cmd.AddValue ("sweepJobs",
+                "Sweep runs at once, 0 for one per CPU", m_jobs);
+  cmd.AddValue ("sweepOutput",
+                "Sweep result file (default: standard output)", m_output);
+}
+
+bool
+TcpClientServerSweep::IsEnabled (void) const
+{
+  return m_enabled;
+}
+
+int
+TcpClientServerSweep::Run (const ScenarioConfig &base)
+{
+  NS_LOG_FUNCTION (this);
+  std::vector<std::string> changes = TcpClientServerBenchmark::Split (m_firstIPchange);
+  std::vector<std::string> maxBytes = TcpClientServerBenchmark::Split (m_maxBytes);
+  std::vector<std::string> clients = TcpClientServerBenchmark::Split (m_clients);
+  uint32_t runs = std::max<uint32_t> (m_runs, 1);
+
+  // Workers would overwrite each other's trace files
+  ScenarioConfig config = base;
+  config.tracing = "none";
+  config.quiet = true;
+
+  // The runs of one combination are consecutive, combination c being
+  // configs[c * runs] to configs[(c + 1) * runs - 1]
+  std::vector<ScenarioConfig> configs;
+  for (uint32_t f = 0; f < std::max<size_t> (changes.size (), 1); f++)
+    {
+      if (!changes.empty ())
+        {
+          config.firstIPchange = std::atof (changes[f].c_str ());
+        }
+      for (uint32_t m = 0; m < std::max<size_t> (maxBytes.size (), 1); m++)
+        {
+          if (!maxBytes.empty ())
+            {
+              config.maxBytes = std::strtoull (maxBytes[m].c_str (), 0, 10);
+            }
+          for (uint32_t c = 0; c < std::max<size_t> (clients.size (), 1); c++)
+            {
+              if (!clients.empty ())
+                {
+                  config.numClients = std::strtoul (clients[c].c_str (), 0, 10);
+                }
+              for (uint32_t r = 0; r < runs; r++)
+                {
+                  config.run = base.run + r;
+                  configs.push_back (config);
+                }
+            }
+        }
+    }
+
+  ScenarioWorkerPool pool;
+  pool.SetJobs (m_jobs);
+  std::cerr << "Sweeping " << configs.size () << " runs on "
+            << pool.GetJobs () << " workers" << std::endl;
+  std::vector<ScenarioResult> results;
+  std::vector<bool> ok;
+  pool.Run (configs, results, ok);
+
+  std::ofstream file;
+  if (!m_output.empty ())
+    {
+      file.open (m_output.c_str ());
+      if (!file)
+        {
+          std::cerr << "Cannot open " << m_output << std::endl;
+          return 1;
+        }
+    }
+  std::ostream &os = m_output.empty () ? std::cout : file;
+
+  os << "firstIPchange,maxBytes,clients,runs,okRuns";
+  WriteSummaryHeader (os, "bytesReceived");
+  WriteSummaryHeader (os, "completedRequests");
+  WriteSummaryHeader (os, "meanGoodput");
+  WriteSummaryHeader (os, "completionP50");
+  WriteSummaryHeader (os, "completionP99");
+  WriteSummaryHeader (os, "fairness");
+  WriteSummaryHeader (os, "wallSeconds");
+  os << std::endl;
+
+  bool failed = false;
+  for (uint32_t first = 0; first < configs.size (); first += runs)
+    {
+      Summary bytes, requests, goodput, p50, p99, fairness, wall;
+      uint32_t okRuns = 0;
+      for (uint32_t i = first; i < first + runs; i++)
+        {
+          if (!ok[i])
+            {
+              failed = true;
+              continue;
+            }
+          okRuns++;
+          bytes.Add (results[i].bytesReceived);
+          requests.Add (results[i].completedRequests);
+          goodput.Add (results[i].meanGoodput);
+          p50.Add (results[i].completionP50);
+          p99.Add (results[i].completionP99);
+          fairness.Add (results[i].fairness);
+          wall.Add (results[i].wallSeconds);
+        }
+      const ScenarioConfig &c = configs[first];
+      os << c.firstIPchange << "," << c.maxBytes << "," << c.numClients << ","
+         << runs << "," << okRuns;
+      WriteSummary (os, bytes);
+      WriteSummary (os, requests);
+      WriteSummary (os, goodput);
+      WriteSummary (os, p50);
+      WriteSummary (os, p99);
+      WriteSummary (os, fairness);
+      WriteSummary (os, wall);
+      os << std::endl;
+    }
+  return failed ? 1 : 0;
+}
+
+void
+TcpClientServerSweep::WriteSummaryHeader (std::ostream &os, const std::string &name)
+{
+  os << "," << name << "Mean," << name << "StdDev";
+}
+
+void
+TcpClientServerSweep::WriteSummary (std::ostream &os, const Summary &summary)
+{
+  os << "," << summary.GetMean () << "," << summary.GetStdDev ();
+}
+
+} // namespace ns3
@@ -0,0 +1,93 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef TCP_CLIENT_SERVER_SWEEP_H
+#define TCP_CLIENT_SERVER_SWEEP_H
+
+#include "tcp-client-server.h"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief Parameter sweep of the tcp-client-server scenario over all cores.
+ *
+ * Runs every combination of firstIPchange, maxBytes and client count for
+ * a number of seeds (RngSeedManager run numbers), in parallel worker
+ * processes, one per CPU by default.  The results of the runs of each
+ * combination are merged into mean and standard deviation, and written
+ * to one CSV file, one row per combination.
+ */
+class TcpClientServerSweep
+{
+public:
+  TcpClientServerSweep ();
+
+  /**
+   * \brief Register the sweep options on a command line.
+   * \param cmd the command line
+   */
+  void AddOptions (CommandLine &cmd);
+
+  /**
+   * \return true if the sweep was asked for on the command line
+   */
+  bool IsEnabled (void) const;
+
+  /**
+   * \brief Run every configuration of the sweep and write the results.
+   * \param base the parameters not swept
+   * \return the exit status of the program
+   */
+  int Run (const ScenarioConfig &base);
+
+private:
+  /// Mean and standard deviation of one metric over the runs of a combination
+  class Summary
+  {
+  public:
+    Summary ();
+    /**
+     * \param value a sample
+     */
+    void Add (double value);
+    /**
+     * \return the mean of the samples
+     */
+    double GetMean (void) const;
+    /**
+     * \return the sample standard deviation
+     */
+    double GetStdDev (void) const;
+
+  private:
+    uint32_t m_n;    //!< Number of samples
+    double   m_sum;  //!< Sum of the samples
+    double   m_sum2; //!< Sum of the squared samples
+  };
+
+  /**
+   * \param os the output stream
+   * \param name the name of the metric
+   */
+  static void WriteSummaryHeader (std::ostream &os, const std::string &name);
+  /**
+   * \param os the output stream
+   * \param summary the metric
+   */
+  static void WriteSummary (std::ostream &os, const Summary &summary);
+
+  bool        m_enabled;       //!< Run the sweep instead of the scenario
+  std::string m_firstIPchange; //!< firstIPchange values to sweep
+  std::string m_maxBytes;      //!< Transfer sizes to sweep
+  std::string m_clients;       //!< Client counts to sweep
+  uint32_t    m_runs;          //!< Seeds per combination
+  uint32_t    m_jobs;          //!< Concurrent runs, 0 for one per CPU
+  std::string m_output;        //!< Result file, standard output if empty
+};
+
+} // namespace ns3
+
+#endif /* TCP_CLIENT_SERVER_SWEEP_H */
@@ -1,5 +1,5 @@
 //
-// Network topology
+// Network topology (default: --topology=star --numClients=2)
 //
 //  n0
 //     \ 1 Mb/s, 5ms
@@ -9,12 +9,30 @@
 //     / 1 Mb/s, 5ms
 //   n1
 //
-// - Flow from n0 to n1 using TcpClientServerApplication.
-// - Tracing of queues and packet receptions to file "tcp-client-server.tr"
-//   and pcap tracing available when tracing is turned on.
+// --numClients, --topology=star|dumbbell|multitier and the link options
+// scale this up, see ClientServerTopology.
+//
+// - Flows from n3 to n0 and n1 using TcpServerApplication and
+//   TcpClientApplication, or TcpMultiStreamClientApplication with --streams.
+// - Client addresses change at the times given by --mobility/--mobilityFile
+//   (by default at firstIPchange and back at 5.1s) and the clients reconnect.
+// - With --distributed=1 under mpirun (ns-3 built with MPI), the nodes are
+//   partitioned over the ranks as described in ClientServerTopology and the
+//   results of all ranks are merged on every rank.
+// - With --cacheSize, the clients fetch their objects through a caching
+//   proxy on the edge router (n2), see CachingProxyApplication.
+// - Tracing is off by default.  --tracing=summary writes a binary flow
+//   record per completed request and per client to "tcp-client-server.flows",
+//   --tracing=sampled adds one in traceSample received packets, and
+//   --tracing=pcap adds ascii tracing of queues and packet receptions to
+//   "tcp-client-server.tr" and pcap tracing.
 
 #include <string>
 #include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <sys/resource.h>
 #include "ns3/core-module.h"
 #include "ns3/point-to-point-module.h"
 #include "ns3/internet-module.h"
@@ -35,211 +53,756 @@
 
 #include "tcp-server-application.h"
 #include "tcp-client-application.h"
+#include "tcp-multi-stream-client-application.h"
+#include "address-change-scheduler.h"
+#include "client-server-topology.h"
+#include "tcp-client-server.h"
+#include "tcp-client-server-benchmark.h"
+#include "tcp-client-server-sweep.h"
+#include "flow-record-writer.h"
+#include "fct-collector.h"
+#include "server-pool.h"
+#include "caching-proxy-application.h"
+#include "workload-distribution.h"
+
+#ifdef NS3_MPI
+#include "ns3/mpi-interface.h"
+#include <mpi.h>
+#endif
 
 using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE ("TcpClientServerExample");
 
 uint16_t port = 9;  // well-known echo port number
-double firstIPchange = 0.3;
+bool quiet = false;
 ApplicationContainer clientApps;
 ApplicationContainer serverApps;
 
 /************************************************************************************/
 
-void dynamicClient(Ptr<Node> node, int id, Ipv4Address servAddress,
-									 Ipv4InterfaceContainer inetFace, bool ipChanged)
+/// What the report needs from a client application of either kind
+struct ClientFigures
 {
-  if (Simulator::Now().GetSeconds() > firstIPchange && Simulator::Now().GetSeconds() < (firstIPchange+0.2) && !ipChanged)
-  {
-    std::cout << "At time " << Simulator::Now().GetSeconds() << std::endl;
-
-    Ptr<TcpServerApplication> sink1 = DynamicCast<TcpServerApplication> (serverApps.Get (0));
-    std::cout << "Server Total Bytes Received: "
-              << sink1->GetTotalRx () << std::endl;
-    
-    Ptr<TcpClientApplication> client = DynamicCast<TcpClientApplication> (clientApps.Get (id));
-    std::cout << "Client " << id << " Total Bytes Received: " 
-              << client->GetTotalRx () << std::endl;
-
-    // Get Ipv4 instance of the node
-    Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-    // Get Ipv4InterfaceAddress of xth interface.
-    Ipv4Address addrBefore = ipv4->GetAddress (1, 0).GetLocal ();
-
-    std::pair< Ptr<Ipv4>, uint32_t > face = inetFace.Get(0);
-    if(id == 0){
-    	node->GetObject<Ipv4>()->RemoveAddress(face.second,"10.1.1.1");
-    	node->GetObject<Ipv4>()->AddAddress(face.second,
-                                     Ipv4InterfaceAddress(Ipv4Address("10.1.1.3"),
-                                     Ipv4Mask("255.255.255.0")));
-    }
-    else if(id == 1){
-    	node->GetObject<Ipv4>()->RemoveAddress(face.second,"10.1.2.1");
-    	node->GetObject<Ipv4>()->AddAddress(face.second,
-                                     Ipv4InterfaceAddress(Ipv4Address("10.1.2.3"),
-                                     Ipv4Mask("255.255.255.0")));
-    }
-
-    Ipv4Address addrAfter = ipv4->GetAddress (1, 0).GetLocal ();
-    
-    std::cout << ">>> Client " << id << " IP changed from "
-              << addrBefore << " to " << addrAfter << " <<<" << std::endl;
-	  
-    // connection restart
-    client->StartConnection();
-    ipChanged = true;
-  }
+  uint64_t totalRx;              //!< Bytes received on the current connections
+  uint64_t completeRx;           //!< Bytes received on all connections
+  uint32_t completedRequests;    //!< Requests, or objects, fully received
+  const TcpTransferStats *stats; //!< Statistics of the completed requests
+};
+
+ClientFigures getClientFigures (Ptr<Application> app)
+{
+  ClientFigures figures;
+  Ptr<TcpMultiStreamClientApplication> multi = DynamicCast<TcpMultiStreamClientApplication> (app);
+  if (multi)
+    {
+      figures.totalRx = multi->GetTotalRx ();
+      figures.completeRx = multi->GetCompleteRx ();
+      figures.completedRequests = multi->GetCompletedRequests ();
+      figures.stats = &multi->GetStats ();
+      return figures;
+    }
+  Ptr<TcpClientApplication> client = DynamicCast<TcpClientApplication> (app);
+  figures.totalRx = client->GetTotalRx ();
+  figures.completeRx = client->GetCompleteRx ();
+  figures.completedRequests = client->GetCompletedRequests ();
+  figures.stats = &client->GetStats ();
+  return figures;
+}
 
-  else if (Simulator::Now().GetSeconds() > 5.0 && ipChanged)
+/**
+ * Append the mean goodput of every connection of a client application
+ * that completed a transfer.
+ */
+void addConnectionGoodputs (Ptr<Application> app, std::vector<double> &goodputs)
+{
+  Ptr<TcpMultiStreamClientApplication> multi = DynamicCast<TcpMultiStreamClientApplication> (app);
+  for (uint32_t i = 0; multi && i < multi->GetNStreams (); i++)
+    {
+      if (multi->GetStreamStats (i).GetN () > 0)
+        {
+          goodputs.push_back (multi->GetStreamStats (i).GetMeanGoodput ());
+        }
+    }
+  Ptr<TcpClientApplication> client = DynamicCast<TcpClientApplication> (app);
+  if (client && client->GetStats ().GetN () > 0)
+    {
+      goodputs.push_back (client->GetStats ().GetMeanGoodput ());
+    }
+}
+
+/**
+ * \return Jain's fairness index of the values, 1 when all are equal
+ */
+double jainIndex (const std::vector<double> &values)
+{
+  double sum = 0;
+  double sum2 = 0;
+  for (uint32_t i = 0; i < values.size (); i++)
+    {
+      sum += values[i];
+      sum2 += values[i] * values[i];
+    }
+  return sum2 > 0 ? sum * sum / (values.size () * sum2) : 0;
+}
+
+/// Shares of the server's transmit path of the closed connections
+struct FlowShares
+{
+  uint32_t n;   //!< Connections closed
+  double sum;   //!< Sum of their shares
+  double min;   //!< Smallest share
+};
+
+void flowShare (FlowShares *shares, const Address &peer, uint64_t bytes, double share)
+{
+  shares->min = shares->n == 0 ? share : std::min (shares->min, share);
+  shares->sum += share;
+  ++shares->n;
+}
+
+void addressChanged(Ptr<Node> node, Ipv4Address addrBefore, Ipv4Address addrAfter)
+{
+  // Every rank changes the address of its copy of the node, but only the
+  // rank of the node has its applications
+  if (node->GetSystemId () != Simulator::GetSystemId ())
+    {
+      return;
+    }
+  if (!quiet)
+    {
+      std::cout << "At time " << Simulator::Now().GetSeconds() << std::endl;
+
+      if (serverApps.GetN () > 0)
+        {
+          Ptr<TcpServerApplication> sink1 = DynamicCast<TcpServerApplication> (serverApps.Get (0));
+          std::cout << "Server Total Bytes Received: "
+                    << sink1->GetTotalRx () << std::endl;
+        }
+    }
+
+  // connection restart of every client on the node
+  for (uint32_t i = 0; i < node->GetNApplications (); i++)
   {
-    std::cout << "At time " << Simulator::Now().GetSeconds() << std::endl;
-
-    Ptr<TcpServerApplication> sink1 = DynamicCast<TcpServerApplication> (serverApps.Get (0));
-    std::cout << "Server Total Bytes Received: "
-              << sink1->GetTotalRx () << std::endl;
-    
-    Ptr<TcpClientApplication> client = DynamicCast<TcpClientApplication> (clientApps.Get (id));
-    std::cout << "Client " << id << " Total Bytes Received: " 
-              << client->GetTotalRx () << std::endl;
-
-    // Get Ipv4 instance of the node
-    Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-    // Get Ipv4InterfaceAddress of xth interface.
-    Ipv4Address addrBefore = ipv4->GetAddress (1, 0).GetLocal ();
-
-    std::pair< Ptr<Ipv4>, uint32_t > face = inetFace.Get(0);
-    if(id == 0){
-      node->GetObject<Ipv4>()->RemoveAddress(face.second,"10.1.1.3");
-      node->GetObject<Ipv4>()->AddAddress(face.second,
-                                     Ipv4InterfaceAddress(Ipv4Address("10.1.1.1"),
-                                     Ipv4Mask("255.255.255.0")));
-    }
-    else if(id == 1){
-      node->GetObject<Ipv4>()->RemoveAddress(face.second,"10.1.2.3");
-      node->GetObject<Ipv4>()->AddAddress(face.second,
-                                     Ipv4InterfaceAddress(Ipv4Address("10.1.2.1"),
-                                     Ipv4Mask("255.255.255.0")));
-    }
-
-    Ipv4Address addrAfter = ipv4->GetAddress (1, 0).GetLocal ();
-    
-    std::cout << ">>> Client " << id << " IP changed from "
-              << addrBefore << " to " << addrAfter << " <<<" << std::endl;
-    
-    // connection restart
-    client->StartConnection();
-    ipChanged = false;
+    Ptr<Application> app = node->GetApplication (i);
+    Ptr<TcpClientApplication> client = DynamicCast<TcpClientApplication> (app);
+    Ptr<TcpMultiStreamClientApplication> multi = DynamicCast<TcpMultiStreamClientApplication> (app);
+    if (!client && !multi)
+    {
+      continue;
+    }
+    if (!quiet)
+      {
+        std::cout << "Client on node " << node->GetId () << " Total Bytes Received: "
+                  << getClientFigures (app).totalRx << std::endl;
+        std::cout << ">>> Client on node " << node->GetId () << " IP changed from "
+                  << addrBefore << " to " << addrAfter << " <<<" << std::endl;
+      }
+    if (client)
+      {
+        client->StartConnection();
+      }
+    else
+      {
+        multi->StartConnection ();
+      }
   }
+}
+
+/// Amount of tracing done by RunScenario
+enum TraceLevel
+{
+  TRACE_NONE,    //!< No tracing
+  TRACE_SUMMARY, //!< Flow records of requests and clients
+  TRACE_SAMPLED, //!< Flow records plus sampled packets
+  TRACE_PCAP     //!< Flow records plus ascii and pcap traces of every packet
+};
 
-  Simulator::Schedule(Seconds(0.1), &dynamicClient, node, id,
-  										servAddress, inetFace, ipChanged);
+/// State of the sampling of received packets
+struct PacketSampler
+{
+  FlowRecordWriter *writer; //!< Where the samples go
+  uint32_t every;           //!< Sample one in this many packets
+  uint64_t seen;            //!< Packets seen so far
+};
+
+TraceLevel parseTraceLevel (const std::string &level)
+{
+  // The boolean values are those of the former --tracing flag
+  if (level == "none" || level == "0" || level == "false")
+    {
+      return TRACE_NONE;
+    }
+  if (level == "summary")
+    {
+      return TRACE_SUMMARY;
+    }
+  if (level == "sampled")
+    {
+      return TRACE_SAMPLED;
+    }
+  if (level == "pcap" || level == "1" || level == "true")
+    {
+      return TRACE_PCAP;
+    }
+  NS_FATAL_ERROR ("Unknown trace level " << level);
+  return TRACE_NONE;
 }
 
-int
-main (int argc, char *argv[])
+void transferComplete (FlowRecordWriter *writer, uint32_t node, uint32_t requestId,
+                       uint64_t bytes, Time timeToFirstByte, Time timeToCompletion)
+{
+  FlowRecordWriter::Record record;
+  record.type = FlowRecordWriter::TRANSFER;
+  record.node = node;
+  record.id = requestId;
+  record.size = 0;
+  record.bytes = bytes;
+  record.time = Simulator::Now ().GetNanoSeconds ();
+  record.t1 = timeToFirstByte.GetNanoSeconds ();
+  record.t2 = timeToCompletion.GetNanoSeconds ();
+  writer->Write (record);
+}
+
+void packetReceived (PacketSampler *sampler, Ptr<NetDevice> device, Ptr<const Packet> packet)
 {
+  if (sampler->seen++ % sampler->every != 0)
+    {
+      return;
+    }
+  FlowRecordWriter::Record record;
+  record.type = FlowRecordWriter::PACKET;
+  record.node = device->GetNode ()->GetId ();
+  record.id = device->GetIfIndex ();
+  record.size = packet->GetSize ();
+  record.bytes = packet->GetUid ();
+  record.time = Simulator::Now ().GetNanoSeconds ();
+  record.t1 = 0;
+  record.t2 = 0;
+  sampler->writer->Write (record);
+}
 
-  bool tracing = true;
-  uint32_t maxBytes = (15*1024);
+#ifdef NS3_MPI
+/// A completed transfer, as exchanged between ranks
+struct TransferSample
+{
+  uint64_t bytes;            //!< Bytes transferred
+  int64_t  timeToFirstByte;  //!< Time to first byte, in ns
+  int64_t  timeToCompletion; //!< Time to completion, in ns
+};
 
-  bool ipChanged[2] = {false};
+void transferSampled (std::vector<TransferSample> *samples, uint32_t requestId,
+                      uint64_t bytes, Time timeToFirstByte, Time timeToCompletion)
+{
+  TransferSample sample;
+  sample.bytes = bytes;
+  sample.timeToFirstByte = timeToFirstByte.GetNanoSeconds ();
+  sample.timeToCompletion = timeToCompletion.GetNanoSeconds ();
+  samples->push_back (sample);
+}
 
-//
-// Allow the user to override any of the defaults at
-// run-time, via command-line arguments
-//
-  CommandLine cmd;
-  cmd.AddValue ("tracing", "Flag to enable/disable tracing", tracing);
+/**
+ * Sum the counters of all ranks into result, keep the largest peak RSS
+ * and wall-clock time of a rank, rebuild the statistics of
+ * the transfers of all ranks in all, and gather the connection goodputs
+ * of all ranks.
+ */
+void mergeRanks (ScenarioResult &result, const std::vector<TransferSample> &local,
+                 TcpTransferStats &all, std::vector<double> &goodputs)
+{
+  uint64_t counters[4] = { result.events, result.bytesReceived,
+                           result.completedRequests, result.serverSendCalls };
+  MPI_Allreduce (MPI_IN_PLACE, counters, 4, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+  result.events = counters[0];
+  result.bytesReceived = counters[1];
+  result.completedRequests = counters[2];
+  result.serverSendCalls = counters[3];
+  MPI_Allreduce (MPI_IN_PLACE, &result.peakRssKb, 1, MPI_UINT64_T, MPI_MAX, MPI_COMM_WORLD);
+  MPI_Allreduce (MPI_IN_PLACE, &result.wallSeconds, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+
+  int size;
+  MPI_Comm_size (MPI_COMM_WORLD, &size);
+  int count = local.size () * sizeof (TransferSample);
+  std::vector<int> counts (size);
+  std::vector<int> offsets (size);
+  MPI_Allgather (&count, 1, MPI_INT, &counts[0], 1, MPI_INT, MPI_COMM_WORLD);
+  int total = 0;
+  for (int r = 0; r < size; r++)
+    {
+      offsets[r] = total;
+      total += counts[r];
+    }
+  std::vector<TransferSample> samples (total / sizeof (TransferSample));
+  MPI_Allgatherv (local.empty () ? 0 : &local[0], count, MPI_BYTE,
+                  samples.empty () ? 0 : &samples[0], &counts[0], &offsets[0], MPI_BYTE,
+                  MPI_COMM_WORLD);
+  all = TcpTransferStats ();
+  for (uint32_t i = 0; i < samples.size (); i++)
+    {
+      all.Add (samples[i].bytes, NanoSeconds (samples[i].timeToFirstByte),
+               NanoSeconds (samples[i].timeToCompletion));
+    }
+
+  int n = goodputs.size ();
+  MPI_Allgather (&n, 1, MPI_INT, &counts[0], 1, MPI_INT, MPI_COMM_WORLD);
+  total = 0;
+  for (int r = 0; r < size; r++)
+    {
+      offsets[r] = total;
+      total += counts[r];
+    }
+  std::vector<double> localGoodputs (goodputs);
+  goodputs.resize (total);
+  MPI_Allgatherv (localGoodputs.empty () ? 0 : &localGoodputs[0], n, MPI_DOUBLE,
+                  goodputs.empty () ? 0 : &goodputs[0], &counts[0], &offsets[0], MPI_DOUBLE,
+                  MPI_COMM_WORLD);
+}
+#endif
+
+namespace ns3 {
+
+ScenarioConfig::ScenarioConfig ()
+  : tracing ("none"),
+    traceFile ("tcp-client-server.flows"),
+    traceSample (100),
+    traceBuffer (1 << 20),
+    quiet (false),
+    maxBytes (15*1024),
+    firstIPchange (0.3),
+    mobilitySpread (0),
+    topology ("star"),
+    numClients (2),
+    numServers (1),
+    serverSelection ("RoundRobin"),
+    fanOut (16),
+    addressPool (1),
+    accessRate ("1Mbps"),
+    accessDelay ("5ms"),
+    bottleneckRate ("1Mbps"),
+    bottleneckDelay ("5ms"),
+    sendSize (512),
+    adaptiveSendSize (false),
+    resume (false),
+    reconnect (false),
+    numRequests (1),
+    pipelineDepth (1),
+    streams (1),
+    cacheSize (0),
+    cachePolicy ("Lru"),
+    maxActive (0),
+    maxPending (0),
+    scheduler ("Greedy"),
+    quantum (4096),
+    coalesce (false),
+    flowRate ("0bps"),
+    maxRate ("0bps"),
+    pacingBurst (16384),
+    initialCwnd (0),
+    sndBufSize (0),
+    rcvBufSize (0),
+    segmentSize (0),
+    stopTime (10.0),
+    seed (1),
+    run (1)
+{
+}
+
+void
+AddScenarioOptions (CommandLine &cmd, ScenarioConfig &config)
+{
+  cmd.AddValue ("tracing", "Trace level: none, summary, sampled or pcap", config.tracing);
+  cmd.AddValue ("traceFile", "File of the binary flow records", config.traceFile);
+  cmd.AddValue ("traceSample",
+                "Record one in this many received packets at the sampled level",
+                config.traceSample);
+  cmd.AddValue ("traceBuffer",
+                "Size of the blocks of flow records written, in bytes", config.traceBuffer);
+  cmd.AddValue ("fctFile",
+                "Collect flow completion times and write their histograms, by flow size, to this file",
+                config.fctFile);
+  cmd.AddValue ("quiet", "Print nothing but the final report", config.quiet);
   cmd.AddValue ("maxBytes",
-                "Total number of bytes for application to send", maxBytes);
+                "Total number of bytes for application to send", config.maxBytes);
   cmd.AddValue ("firstIPchange",
-                "Time for first IP change", firstIPchange);
-  cmd.Parse (argc, argv);
+                "Time for first IP change", config.firstIPchange);
+  cmd.AddValue ("mobility",
+                "Address changes as time,node,interface,address/prefix;... "
+                "(default: every client moves at firstIPchange and back at 5.1s)",
+                config.mobility);
+  cmd.AddValue ("mobilityFile",
+                "File of address changes, one time,node,interface,address/prefix per line",
+                config.mobilityFile);
+  cmd.AddValue ("mobilitySpread",
+                "Spread the default address changes of the clients over this many seconds",
+                config.mobilitySpread);
+  cmd.AddValue ("topology", "Topology: star, dumbbell or multitier", config.topology);
+  cmd.AddValue ("numClients", "Number of clients", config.numClients);
+  cmd.AddValue ("numServers", "Number of servers", config.numServers);
+  cmd.AddValue ("serverSelection",
+                "How a client picks its server: RoundRobin, LeastOutstanding, "
+                "PowerOfTwo or ConsistentHash",
+                config.serverSelection);
+  cmd.AddValue ("fanOut", "Clients per access router in the multitier topology", config.fanOut);
+  cmd.AddValue ("addressPool", "Spare addresses per client to move to", config.addressPool);
+  cmd.AddValue ("accessRate", "Rate of the client links", config.accessRate);
+  cmd.AddValue ("accessDelay", "Delay of the client links", config.accessDelay);
+  cmd.AddValue ("bottleneckRate", "Rate of the router and server links", config.bottleneckRate);
+  cmd.AddValue ("bottleneckDelay", "Delay of the router and server links", config.bottleneckDelay);
+  cmd.AddValue ("sendSize",
+                "Size of each write of the server", config.sendSize);
+  cmd.AddValue ("adaptiveSendSize",
+                "Size server writes from the TCP segment size and tx space",
+                config.adaptiveSendSize);
+  cmd.AddValue ("resume",
+                "Resume transfers after an IP change instead of restarting them",
+                config.resume);
+  cmd.AddValue ("reconnect",
+                "Reconnect on a new socket bound to the new address after an IP change, "
+                "retrying failed attempts with backoff",
+                config.reconnect);
+  cmd.AddValue ("numRequests",
+                "Requests per client connection (0 for no limit)", config.numRequests);
+  cmd.AddValue ("pipelineDepth",
+                "Requests a client keeps outstanding at once", config.pipelineDepth);
+  cmd.AddValue ("streams",
+                "Parallel connections each client splits its downloads over", config.streams);
+  cmd.AddValue ("objectSize",
+                "Distribution of the requested object sizes: fixed:BYTES, exp:MEAN, "
+                "pareto:MEAN,SHAPE[,BOUND], uniform:MIN,MAX, zipf:N,ALPHA or cdf:FILE "
+                "(default maxBytes)",
+                config.objectSize);
+  cmd.AddValue ("interArrival",
+                "Distribution of the seconds between requests, e.g. exp:0.05 for "
+                "Poisson arrivals (default: next request when one completes)",
+                config.interArrival);
+  cmd.AddValue ("onTime", "Distribution of the periods in which requests arrive, in seconds",
+                config.onTime);
+  cmd.AddValue ("offTime", "Distribution of the periods without arrivals, in seconds",
+                config.offTime);
+  cmd.AddValue ("objects",
+                "Distribution of the requested object ids, e.g. zipf:1000,0.8 "
+                "(default: no ids, nothing is cached)",
+                config.objects);
+  cmd.AddValue ("cacheSize",
+                "Bytes of a caching proxy on the edge router between the clients "
+                "and the servers (0 for no proxy)",
+                config.cacheSize);
+  cmd.AddValue ("cachePolicy", "Eviction policy of the proxy: Lru, Lfu or Size",
+                config.cachePolicy);
+  cmd.AddValue ("maxActiveConnections",
+                "Connections the server serves at once (0 for no limit)", config.maxActive);
+  cmd.AddValue ("maxPendingConnections",
+                "Connections waiting for the server before it refuses more (0 for no limit)",
+                config.maxPending);
+  cmd.AddValue ("scheduler",
+                "How the server shares writes between connections: Greedy, RoundRobin or Drr",
+                config.scheduler);
+  cmd.AddValue ("quantum", "Bytes per connection and turn of the Drr scheduler", config.quantum);
+  cmd.AddValue ("coalesce",
+                "Share the payload of responses sending the same object at the same time",
+                config.coalesce);
+  cmd.AddValue ("flowRate",
+                "Rate the server paces each connection to (0bps for no pacing)",
+                config.flowRate);
+  cmd.AddValue ("maxRate",
+                "Rate the server caps all its connections to (0bps for no cap)",
+                config.maxRate);
+  cmd.AddValue ("pacingBurst", "Token bucket depth of the pacing, in bytes",
+                config.pacingBurst);
+  cmd.AddValue ("congestionControl",
+                "TCP congestion control of the clients and servers, e.g. TcpNewReno, "
+                "TcpCubic or TcpBbr (default: the ns-3 default)",
+                config.congestionControl);
+  cmd.AddValue ("initialCwnd",
+                "Initial congestion window, in segments (0 for the default)",
+                config.initialCwnd);
+  cmd.AddValue ("sndBufSize", "Socket tx buffer size, in bytes (0 for the default)",
+                config.sndBufSize);
+  cmd.AddValue ("rcvBufSize", "Socket rx buffer size, in bytes (0 for the default)",
+                config.rcvBufSize);
+  cmd.AddValue ("segmentSize", "TCP segment size, in bytes (0 for the default)",
+                config.segmentSize);
+  cmd.AddValue ("stopTime", "Simulated time, in seconds", config.stopTime);
+  cmd.AddValue ("seed", "Seed of the random number generator", config.seed);
+  cmd.AddValue ("run", "Run number of the random number generator", config.run);
+}
+
+ScenarioResult
+RunScenario (const ScenarioConfig &config)
+{
+  uint32_t systemId = 0;
+  uint32_t systemCount = 1;
+#ifdef NS3_MPI
+  if (MpiInterface::IsEnabled ())
+    {
+      systemId = MpiInterface::GetSystemId ();
+      systemCount = MpiInterface::GetSize ();
+    }
+#endif
+  // Rank 0 reports for all of them
+  quiet = config.quiet || systemId != 0;
+  RngSeedManager::SetSeed (config.seed);
+  RngSeedManager::SetRun (config.run);
 
 //
-// Explicitly create the nodes required by the topology (shown above).
-//
-  NS_LOG_INFO ("Create nodes.");
-  NodeContainer nodes;
-  nodes.Create (4);
-  NodeContainer n0n2 = NodeContainer (nodes.Get (0), nodes.Get (2));
-  NodeContainer n1n2 = NodeContainer (nodes.Get (1), nodes.Get (2));
-  NodeContainer n3n2 = NodeContainer (nodes.Get (3), nodes.Get (2));
-
-  NS_LOG_INFO ("Create channels.");
-//
-// Explicitly create the point-to-point link required by the topology (shown above).
+// Create the nodes, links and addresses of the topology (shown above).
 //
-  PointToPointHelper pointToPoint;
-  pointToPoint.SetDeviceAttribute ("DataRate", StringValue ("1Mbps"));
-  pointToPoint.SetChannelAttribute ("Delay", StringValue ("5ms"));
+  NS_LOG_INFO ("Create topology.");
+  ClientServerTopology net;
+  net.SetType (ClientServerTopology::ParseType (config.topology));
+  net.SetClientCount (config.numClients);
+  net.SetServerCount (std::max<uint32_t> (config.numServers, 1));
+  net.SetFanOut (config.fanOut);
+  net.SetAddressPoolSize (config.addressPool);
+  net.SetAccessLink (config.accessRate, config.accessDelay);
+  net.SetBottleneckLink (config.bottleneckRate, config.bottleneckDelay);
+  net.SetSystemCount (systemCount);
+  net.Build ();
+  NodeContainer clientNodes = net.GetClients ();
+  uint32_t numClients = config.numClients;
 
-  NetDeviceContainer d0d2 = pointToPoint.Install (n0n2);
-  NetDeviceContainer d1d2 = pointToPoint.Install (n1n2);
-  NetDeviceContainer d3d2 = pointToPoint.Install (n3n2);
+  NS_LOG_INFO ("Create Applications.");
 
 //
-// Install the internet stack on the nodes
+// The servers, whose selector the clients share
 //
-  InternetStackHelper internet;
-  internet.Install (nodes);
+  // Every rank has a selector of its own, which only sees the load of its
+  // own clients
+  if (systemCount > 1 && config.serverSelection != "RoundRobin"
+      && config.serverSelection != "ConsistentHash")
+    {
+      NS_FATAL_ERROR ("--serverSelection=" << config.serverSelection
+                      << " depends on the load of all the clients; use RoundRobin"
+                      << " or ConsistentHash in a distributed simulation");
+    }
+  ServerPoolHelper pool (port);
+  pool.SetSelectorAttribute ("Policy", StringValue (config.serverSelection));
+  Ptr<ServerSelector> selector = pool.GetSelector ();
+  selector->AssignStreams (5 * numClients);
 
 //
-// We've got the "hardware" in place.  Now we need to add IP addresses.
+// With a cache, the clients talk to a proxy on the edge router, which
+// fetches its misses from one server of the pool
 //
-  NS_LOG_INFO ("Assign IP Addresses.");
-  Ipv4AddressHelper ipv4;
-
-  ipv4.SetBase ("10.1.1.0", "255.255.255.0");
-  Ipv4InterfaceContainer i0i2 = ipv4.Assign (d0d2);
-
-  ipv4.SetBase ("10.1.2.0", "255.255.255.0");
-  Ipv4InterfaceContainer i1i2 = ipv4.Assign (d1d2);
-
-  ipv4.SetBase ("10.1.3.0", "255.255.255.0");
-  Ipv4InterfaceContainer i3i2 = ipv4.Assign (d3d2);
-
-  // Create router nodes, initialize routing database and set up the routing
-  // tables in the nodes.
-  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
-
-  NS_LOG_INFO ("Create Applications.");
+  bool caching = config.cacheSize > 0;
+  Address clientRemote = InetSocketAddress (net.GetServerAddress (0), port);
+  if (caching)
+    {
+      clientRemote = InetSocketAddress (net.GetEdgeRouterAddress (), port);
+    }
 
 //
-// Create a TcpClientApplication and install it on node 0
+// Create a TcpClientApplication, or a TcpMultiStreamClientApplication, and
+// install it on the clients of this rank; clientApps.Get (k) runs on client
+// localClients[k].
 //
 
-  TcpClientApplicationHelper client (InetSocketAddress (i3i2.GetAddress (0), port));
-  client.SetAttribute ("MaxRxBytes", UintegerValue (maxBytes));
-  clientApps = client.Install (nodes.Get (0));
-  clientApps.Add(client.Install (nodes.Get (1)));
+  TcpClientApplicationHelper client (clientRemote);
+  if (!caching)
+    {
+      client.SetAttribute ("ServerSelector", PointerValue (selector));
+    }
+  client.SetAttribute ("MaxRxBytes", UintegerValue (config.maxBytes));
+  client.SetAttribute ("Resume", BooleanValue (config.resume));
+  client.SetAttribute ("RecreateSocket", BooleanValue (config.reconnect));
+  client.SetAttribute ("NumRequests", UintegerValue (config.numRequests));
+  client.SetAttribute ("PipelineDepth", UintegerValue (config.pipelineDepth));
+  client.SetAttribute ("CongestionControl", StringValue (config.congestionControl));
+  client.SetAttribute ("InitialCwnd", UintegerValue (config.initialCwnd));
+  client.SetAttribute ("SndBufSize", UintegerValue (config.sndBufSize));
+  client.SetAttribute ("RcvBufSize", UintegerValue (config.rcvBufSize));
+  client.SetAttribute ("SegmentSize", UintegerValue (config.segmentSize));
+  TcpMultiStreamClientApplicationHelper multiClient (clientRemote);
+  multiClient.SetAttribute ("Streams", UintegerValue (std::max<uint32_t> (config.streams, 1)));
+  multiClient.SetAttribute ("ObjectSize", UintegerValue (std::max<uint64_t> (config.maxBytes, 1)));
+  multiClient.SetAttribute ("NumObjects", UintegerValue (config.numRequests));
+  multiClient.SetAttribute ("Resume", BooleanValue (config.resume));
+  multiClient.SetAttribute ("CongestionControl", StringValue (config.congestionControl));
+  multiClient.SetAttribute ("InitialCwnd", UintegerValue (config.initialCwnd));
+  multiClient.SetAttribute ("SndBufSize", UintegerValue (config.sndBufSize));
+  multiClient.SetAttribute ("RcvBufSize", UintegerValue (config.rcvBufSize));
+  multiClient.SetAttribute ("SegmentSize", UintegerValue (config.segmentSize));
+  std::vector<uint32_t> localClients;
+  for (uint32_t i = 0; i < numClients; i++)
+    {
+      if (clientNodes.Get (i)->GetSystemId () == systemId)
+        {
+          localClients.push_back (i);
+          clientApps.Add (config.streams > 1 ? multiClient.Install (clientNodes.Get (i))
+                                             : client.Install (clientNodes.Get (i)));
+        }
+    }
+  // Parallel downloads spread their streams over all the servers
+  for (uint32_t k = 0; config.streams > 1 && !caching && k < clientApps.GetN (); k++)
+    {
+      Ptr<TcpMultiStreamClientApplication> app =
+        DynamicCast<TcpMultiStreamClientApplication> (clientApps.Get (k));
+      for (uint32_t s = 1; s < net.GetServers ().GetN (); s++)
+        {
+          app->AddRemote (InetSocketAddress (net.GetServerAddress (s), port));
+        }
+    }
+  // Every client draws its workload from variables and streams of its own,
+  // numbered after the client so that all ranks agree
+  for (uint32_t k = 0; config.streams <= 1 && k < clientApps.GetN (); k++)
+    {
+      Ptr<TcpClientApplication> app = DynamicCast<TcpClientApplication> (clientApps.Get (k));
+      app->SetAttribute ("ObjectSize", PointerValue (CreateDistribution (config.objectSize)));
+      app->SetAttribute ("InterArrivalTime", PointerValue (CreateDistribution (config.interArrival)));
+      app->SetAttribute ("OnTime", PointerValue (CreateDistribution (config.onTime)));
+      app->SetAttribute ("OffTime", PointerValue (CreateDistribution (config.offTime)));
+      app->SetAttribute ("ObjectId", PointerValue (CreateDistribution (config.objects)));
+      // and picks its server by its index among all the clients
+      app->SetAttribute ("SessionId", UintegerValue (localClients[k] + 1));
+      app->AssignStreams (5 * localClients[k]);
+    }
   clientApps.Start (Seconds (0.0));
-  clientApps.Stop (Seconds (10.0));
+  clientApps.Stop (Seconds (config.stopTime));
 
-  for(int i=0; i<2; i++){
-    Ptr<TcpClientApplication> client = DynamicCast<TcpClientApplication> (clientApps.Get (i));
+  for(uint32_t k=0; config.streams <= 1 && k<clientApps.GetN (); k++){
+    Ptr<TcpClientApplication> client = DynamicCast<TcpClientApplication> (clientApps.Get (k));
     client->StartConnection();
   }
 
-  Ipv4Address dstaddr ("10.1.3.1");
 //
-// Create a TcpServerApplicationApplication and install it on node 1
+// Create a TcpServerApplication on every server of this rank
 //
-  TcpServerApplicationHelper server (InetSocketAddress (Ipv4Address::GetAny (), port));
-  server.SetAttribute ("MaxTxBytes", UintegerValue (maxBytes));
-  serverApps = server.Install (nodes.Get (3));
+  pool.SetAttribute ("MaxTxBytes", UintegerValue (config.maxBytes));
+  pool.SetAttribute ("SendSize", UintegerValue (config.sendSize));
+  pool.SetAttribute ("AdaptiveSendSize", BooleanValue (config.adaptiveSendSize));
+  // The proxy keeps its connections to the origin open
+  pool.SetAttribute ("Persistent",
+                     BooleanValue (config.numRequests != 1 || !config.interArrival.empty ()
+                                   || caching));
+  pool.SetAttribute ("MaxActiveConnections", UintegerValue (config.maxActive));
+  pool.SetAttribute ("MaxPendingConnections", UintegerValue (config.maxPending));
+  pool.SetAttribute ("Scheduler", StringValue (config.scheduler));
+  pool.SetAttribute ("Quantum", UintegerValue (config.quantum));
+  pool.SetAttribute ("CoalesceRequests", BooleanValue (config.coalesce));
+  pool.SetAttribute ("FlowRate", DataRateValue (DataRate (config.flowRate)));
+  pool.SetAttribute ("MaxRate", DataRateValue (DataRate (config.maxRate)));
+  pool.SetAttribute ("PacingBurst", UintegerValue (config.pacingBurst));
+  pool.SetAttribute ("CongestionControl", StringValue (config.congestionControl));
+  pool.SetAttribute ("InitialCwnd", UintegerValue (config.initialCwnd));
+  pool.SetAttribute ("SndBufSize", UintegerValue (config.sndBufSize));
+  pool.SetAttribute ("RcvBufSize", UintegerValue (config.rcvBufSize));
+  pool.SetAttribute ("SegmentSize", UintegerValue (config.segmentSize));
+  FlowShares shares;
+  shares.n = 0;
+  shares.sum = 0;
+  shares.min = 0;
+  std::vector<Ipv4Address> serverAddresses;
+  for (uint32_t s = 0; s < net.GetServers ().GetN (); s++)
+    {
+      serverAddresses.push_back (net.GetServerAddress (s));
+    }
+  serverApps = pool.Install (net.GetServers (), serverAddresses);
+  for (uint32_t s = 0; s < serverApps.GetN (); s++)
+    {
+      serverApps.Get (s)->TraceConnectWithoutContext
+        ("FlowShare", MakeBoundCallback (&flowShare, &shares));
+    }
   serverApps.Start (Seconds (0.0));
-  serverApps.Stop (Seconds (10.0));
+  serverApps.Stop (Seconds (config.stopTime));
+
+  // The origin is picked like the server of one more client, on every
+  // rank, once the pool has registered its servers
+  uint32_t origin = caching ? selector->Select (numClients) : 0;
+  Ptr<CachingProxyApplication> proxy;
+  if (caching && net.GetEdgeRouter ()->GetSystemId () == systemId)
+    {
+      CachingProxyApplicationHelper proxyHelper (InetSocketAddress (Ipv4Address::GetAny (), port),
+                                                 InetSocketAddress (net.GetServerAddress (origin), port));
+      proxyHelper.SetAttribute ("CacheSize", UintegerValue (config.cacheSize));
+      proxyHelper.SetAttribute ("EvictionPolicy", StringValue (config.cachePolicy));
+      proxyHelper.SetAttribute ("SendSize", UintegerValue (config.sendSize));
+      proxyHelper.SetAttribute ("CongestionControl", StringValue (config.congestionControl));
+      proxyHelper.SetAttribute ("InitialCwnd", UintegerValue (config.initialCwnd));
+      proxyHelper.SetAttribute ("SndBufSize", UintegerValue (config.sndBufSize));
+      proxyHelper.SetAttribute ("RcvBufSize", UintegerValue (config.rcvBufSize));
+      proxyHelper.SetAttribute ("SegmentSize", UintegerValue (config.segmentSize));
+      ApplicationContainer proxyApps = proxyHelper.Install (net.GetEdgeRouter ());
+      proxyApps.Start (Seconds (0.0));
+      proxyApps.Stop (Seconds (config.stopTime));
+      proxy = DynamicCast<CachingProxyApplication> (proxyApps.Get (0));
+    }
 
 //
 // Set up tracing if enabled
 //
-  if (tracing)
+  TraceLevel traceLevel = parseTraceLevel (config.tracing);
+  FlowRecordWriter flowRecords;
+  PacketSampler sampler;
+  sampler.writer = &flowRecords;
+  sampler.every = std::max<uint32_t> (config.traceSample, 1);
+  sampler.seen = 0;
+  // Each rank writes files of its own
+  std::ostringstream traceSuffix;
+  if (systemCount > 1)
+    {
+      traceSuffix << "-" << systemId;
+    }
+  std::string traceFile = config.traceFile + traceSuffix.str ();
+  if (traceLevel >= TRACE_SUMMARY)
+    {
+      if (!flowRecords.Open (traceFile, config.traceBuffer))
+        {
+          NS_FATAL_ERROR ("Cannot create " << traceFile);
+        }
+      for (uint32_t k = 0; k < clientApps.GetN (); k++)
+        {
+          clientApps.Get (k)->TraceConnectWithoutContext
+            ("TransferComplete",
+             MakeBoundCallback (&transferComplete, &flowRecords, clientApps.Get (k)->GetNode ()->GetId ()));
+        }
+    }
+  if (traceLevel == TRACE_SAMPLED)
+    {
+      for (uint32_t n = 0; n < NodeList::GetNNodes (); n++)
+        {
+          Ptr<Node> node = NodeList::GetNode (n);
+          if (node->GetSystemId () != systemId)
+            {
+              continue;
+            }
+          for (uint32_t d = 0; d < node->GetNDevices (); d++)
+            {
+              Ptr<NetDevice> device = node->GetDevice (d);
+              if (DynamicCast<PointToPointNetDevice> (device))
+                {
+                  device->TraceConnectWithoutContext
+                    ("MacRx", MakeBoundCallback (&packetReceived, &sampler, device));
+                }
+            }
+        }
+    }
+  // Flow completion times as the clients and the server see them
+  FctCollector clientFct;
+  FctCollector serverFct;
+  if (!config.fctFile.empty ())
+    {
+      // The uncontended path of a flow: one access link and the bottleneck
+      DataRate rate = std::min (DataRate (config.accessRate), DataRate (config.bottleneckRate));
+      Time rtt = 2 * (Time (config.accessDelay) + Time (config.bottleneckDelay));
+      clientFct.SetReferencePath (rate, rtt);
+      serverFct.SetReferencePath (rate, rtt);
+      for (uint32_t k = 0; k < clientApps.GetN (); k++)
+        {
+          clientApps.Get (k)->TraceConnectWithoutContext
+            ("TransferComplete", MakeCallback (&FctCollector::Record, &clientFct));
+        }
+      for (uint32_t k = 0; k < serverApps.GetN (); k++)
+        {
+          serverApps.Get (k)->TraceConnectWithoutContext
+            ("ResponseComplete", MakeCallback (&FctCollector::Record, &serverFct));
+        }
+    }
+  if (traceLevel == TRACE_PCAP)
     {
       AsciiTraceHelper ascii;
-      pointToPoint.EnableAsciiAll (ascii.CreateFileStream ("tcp-client-server.tr"));
-      pointToPoint.EnablePcapAll ("tcp-client-server", false);
+      PointToPointHelper pointToPoint;
+      pointToPoint.EnableAsciiAll (ascii.CreateFileStream ("tcp-client-server" + traceSuffix.str () + ".tr"));
+      pointToPoint.EnablePcapAll ("tcp-client-server" + traceSuffix.str (), false);
     }
 
 //
@@ -247,31 +810,305 @@ main (int argc, char *argv[])
 //
   NS_LOG_INFO ("Run Simulation.");
 
-  Simulator::Schedule(Seconds(0.1), &dynamicClient, nodes.Get (0), 0,
-                      dstaddr, i0i2, ipChanged[0]);
+  AddressChangeScheduler addressChanges;
+  if (!config.mobility.empty ())
+    {
+      addressChanges.Parse (config.mobility);
+    }
+  if (!config.mobilityFile.empty ())
+    {
+      addressChanges.Load (config.mobilityFile);
+    }
+  if (config.mobility.empty () && config.mobilityFile.empty ())
+    {
+      // Each client moves to an address of its pool and back home
+      for (uint32_t i = 0; i < numClients && config.addressPool > 0; i++)
+        {
+          AddressChangeEvent event;
+          event.node = clientNodes.Get (i)->GetId ();
+          event.interface = net.GetClientInterface (i);
+          event.mask = net.GetClientMask ();
+          event.time = Seconds (config.firstIPchange + config.mobilitySpread * i / numClients);
+          event.address = net.GetAddressPool (i)[i % config.addressPool];
+          addressChanges.Add (event);
+          event.time = Seconds (5.1 + config.mobilitySpread * i / numClients);
+          event.address = net.GetClientAddress (i);
+          addressChanges.Add (event);
+        }
+    }
+  addressChanges.SetAddressChangeCallback (MakeCallback (&addressChanged));
+  addressChanges.Schedule ();
 
-  Simulator::Schedule(Seconds(0.1), &dynamicClient, nodes.Get (1), 1,
-                      dstaddr, i1i2, ipChanged[1]);
+#ifdef NS3_MPI
+  std::vector<TransferSample> transfers;
+  for (uint32_t k = 0; systemCount > 1 && k < clientApps.GetN (); k++)
+    {
+      clientApps.Get (k)->TraceConnectWithoutContext
+        ("TransferComplete", MakeBoundCallback (&transferSampled, &transfers));
+    }
+#endif
 
-  Simulator::Stop (Seconds (10.0));
+  Simulator::Stop (Seconds (config.stopTime));
+  std::chrono::steady_clock::time_point wallStart = std::chrono::steady_clock::now ();
   Simulator::Run ();
+  std::chrono::duration<double> wall = std::chrono::steady_clock::now () - wallStart;
+
+  ScenarioResult result;
+  result.wallSeconds = wall.count ();
+  result.events = Simulator::GetEventCount ();
+  struct rusage usage;
+  getrusage (RUSAGE_SELF, &usage);
+  result.peakRssKb = usage.ru_maxrss;
+
+  // Aggregate the statistics of all clients before the applications go away
+  TcpTransferStats all;
+  std::vector<double> goodputs;
+  result.bytesReceived = 0;
+  result.completedRequests = 0;
+  for (uint32_t k = 0; k < clientApps.GetN (); k++)
+    {
+      ClientFigures client = getClientFigures (clientApps.Get (k));
+      result.bytesReceived += client.completeRx;
+      result.completedRequests += client.completedRequests;
+      all.Merge (*client.stats);
+      addConnectionGoodputs (clientApps.Get (k), goodputs);
+      if (traceLevel >= TRACE_SUMMARY)
+        {
+          FlowRecordWriter::Record record;
+          record.type = FlowRecordWriter::CLIENT_SUMMARY;
+          record.node = clientApps.Get (k)->GetNode ()->GetId ();
+          record.id = client.completedRequests;
+          record.size = 0;
+          record.bytes = client.completeRx;
+          record.time = Simulator::Now ().GetNanoSeconds ();
+          record.t1 = client.stats->GetMeanTimeToFirstByte ().GetNanoSeconds ();
+          record.t2 = client.stats->GetMeanTimeToCompletion ().GetNanoSeconds ();
+          flowRecords.Write (record);
+        }
+    }
+  flowRecords.Close ();
+  std::string fctFile = config.fctFile + traceSuffix.str ();
+  if (!config.fctFile.empty ())
+    {
+      std::ofstream fct (fctFile.c_str ());
+      if (!fct)
+        {
+          NS_FATAL_ERROR ("Cannot create " << fctFile);
+        }
+      fct << "side,metric,sizeLimit,low,high,count\n";
+      clientFct.WriteHistograms (fct, "client");
+      serverFct.WriteHistograms (fct, "server");
+    }
+  // Totals of the servers of this rank
+  uint64_t serverRx = 0;
+  uint64_t resumedBytes = 0;
+  uint32_t resumedSessions = 0;
+  uint32_t peakActive = 0;
+  uint64_t rejected = 0;
+  uint64_t coalescedRequests = 0;
+  uint64_t coalescedBytes = 0;
+  uint64_t pacingWaits = 0;
+  Time pacingDelay;
+  result.serverSendCalls = 0;
+  for (uint32_t s = 0; s < serverApps.GetN (); s++)
+    {
+      Ptr<TcpServerApplication> sink = DynamicCast<TcpServerApplication> (serverApps.Get (s));
+      serverRx += sink->GetTotalRx ();
+      resumedBytes += sink->GetResumedBytes ();
+      resumedSessions += sink->GetResumedSessions ();
+      peakActive = std::max (peakActive, sink->GetPeakActiveConnections ());
+      rejected += sink->GetRejectedConnections ();
+      coalescedRequests += sink->GetCoalescedRequests ();
+      coalescedBytes += sink->GetCoalescedBytes ();
+      pacingWaits += sink->GetPacingWaits ();
+      pacingDelay += sink->GetPacingDelay ();
+      result.serverSendCalls += sink->GetSendCalls ();
+    }
+#ifdef NS3_MPI
+  if (systemCount > 1)
+    {
+      mergeRanks (result, transfers, all, goodputs);
+    }
+#endif
+  result.fairness = jainIndex (goodputs);
+  result.meanGoodput = all.GetN () > 0 ? all.GetMeanGoodput () : 0;
+  result.completionP50 = all.GetN () > 0 ? all.GetTimeToCompletionPercentile (50).GetSeconds () : 0;
+  result.completionP99 = all.GetN () > 0 ? all.GetTimeToCompletionPercentile (99).GetSeconds () : 0;
+
+  if (!quiet)
+    {
+      std::cout << "Server Total Bytes Received: "
+                << serverRx << std::endl;
+
+      // Per-client output is only readable for small topologies
+      bool perClient = numClients <= 16 && systemCount == 1;
+      for(uint32_t i=0; perClient && i<numClients; i++){
+        std::cout << "Client " << i << " Total Bytes Received: "
+                  << getClientFigures (clientApps.Get (i)).totalRx << std::endl;
+      }
+
+      printf("\nAt end of Simulation:\n");
+      for(uint32_t i=0; perClient && i<numClients; i++){
+        ClientFigures client = getClientFigures (clientApps.Get (i));
+        std::cout << "Client " << i << " Total Bytes Received: "
+                  << client.completeRx << " in "
+                  << client.completedRequests << " completed requests" << std::endl;
+        const TcpTransferStats &stats = *client.stats;
+        if (stats.GetN () > 0)
+          {
+            std::cout << "  goodput " << stats.GetMeanGoodput () / 1e6 << " Mb/s"
+                      << ", time to first byte " << stats.GetMeanTimeToFirstByte ().GetSeconds () << "s"
+                      << ", completion p50/p95/p99 "
+                      << stats.GetTimeToCompletionPercentile (50).GetSeconds () << "/"
+                      << stats.GetTimeToCompletionPercentile (95).GetSeconds () << "/"
+                      << stats.GetTimeToCompletionPercentile (99).GetSeconds () << "s"
+                      << std::endl;
+          }
+      }
+
+      std::cout << "All " << numClients << " clients: " << result.bytesReceived << " bytes received in "
+                << result.completedRequests << " completed requests" << std::endl;
+
+      if (goodputs.size () > 1)
+        {
+          std::cout << "Fairness (Jain's index) of " << goodputs.size ()
+                    << " connections: " << result.fairness << std::endl;
+        }
+      uint32_t reconnections = 0;
+      uint32_t failedAttempts = 0;
+      Time reconnectLatency;
+      for (uint32_t k = 0; config.streams <= 1 && k < clientApps.GetN (); k++)
+        {
+          Ptr<TcpClientApplication> app = DynamicCast<TcpClientApplication> (clientApps.Get (k));
+          reconnections += app->GetReconnections ();
+          failedAttempts += app->GetFailedAttempts ();
+          reconnectLatency += app->GetMeanReconnectLatency () * static_cast<int64_t> (app->GetReconnections ());
+        }
+      if (reconnections > 0 || failedAttempts > 0)
+        {
+          std::cout << "Reconnections: " << reconnections << ", mean time from IP change to first byte "
+                    << (reconnections > 0 ? reconnectLatency.GetSeconds () / reconnections : 0)
+                    << "s, " << failedAttempts << " failed attempts" << std::endl;
+        }
+      std::cout << "Bytes not resent thanks to resumption: "
+                << resumedBytes << " in "
+                << resumedSessions << " resumed sessions" << std::endl;
+      std::cout << "Server send calls: " << result.serverSendCalls << std::endl;
+      std::cout << "Server connections: peak " << peakActive
+                << " served at once, " << rejected
+                << " refused" << std::endl;
+      if (config.coalesce)
+        {
+          std::cout << "Coalesced requests: " << coalescedRequests << ", "
+                    << coalescedBytes << " payload bytes sent without being built again"
+                    << std::endl;
+        }
+      if (pacingWaits > 0)
+        {
+          std::cout << "Pacing: " << pacingWaits << " waits for tokens, "
+                    << pacingDelay.GetSeconds () << "s in total, mean "
+                    << pacingDelay.GetSeconds () * 1000 / pacingWaits << " ms" << std::endl;
+        }
+      for (uint32_t s = 0; selector->GetNServers () > 1 && s < selector->GetNServers (); s++)
+        {
+          std::cout << "Server " << s << ": " << selector->GetClients (s) << " clients, "
+                    << selector->GetRequests (s) << " requests, "
+                    << selector->GetCompletedRequests (s) << " answered with "
+                    << selector->GetBytes (s) << " bytes, peak "
+                    << selector->GetPeakOutstanding (s) << " outstanding" << std::endl;
+        }
+      if (proxy)
+        {
+          std::cout << "Cache of " << config.cacheSize << " bytes (" << config.cachePolicy
+                    << "): " << proxy->GetHits () << " hits in " << proxy->GetRequests ()
+                    << " requests, hit ratio " << proxy->GetHitRatio ()
+                    << ", byte hit ratio " << proxy->GetByteHitRatio () << ", "
+                    << proxy->GetHitBytes () << " bytes not fetched from the servers, "
+                    << proxy->GetCache ().GetEvictions () << " evictions" << std::endl;
+        }
+      if (shares.n > 0)
+        {
+          std::cout << "Server share of " << shares.n << " closed connections: mean "
+                    << shares.sum / shares.n << ", min " << shares.min << std::endl;
+        }
+      if (!config.fctFile.empty ())
+        {
+          std::cout << "Flow completion times of " << clientFct.GetN ()
+                    << " client flows, histograms in " << fctFile << ":" << std::endl;
+          clientFct.Print (std::cout);
+        }
+      if (traceLevel >= TRACE_SUMMARY)
+        {
+          std::cout << "Flow records written to " << traceFile << ": "
+                    << flowRecords.GetRecordCount () << std::endl;
+        }
+      std::cout << "Simulator events: " << result.events
+                << " (" << result.events / result.wallSeconds << " events/s)" << std::endl;
+      std::cout << "Simulated MB per wall-clock second: "
+                << result.bytesReceived / (1024.0 * 1024.0) / result.wallSeconds << std::endl;
+    }
+
+  clientApps = ApplicationContainer ();
+  serverApps = ApplicationContainer ();
   Simulator::Destroy ();
   NS_LOG_INFO ("Done.");
+  return result;
+}
 
-  Ptr<TcpServerApplication> sink1 = DynamicCast<TcpServerApplication> (serverApps.Get (0));
-  std::cout << "Server Total Bytes Received: "
-  					<< sink1->GetTotalRx () << std::endl;
-  
-  for(int i=0; i<2; i++){
-	  Ptr<TcpClientApplication> client = DynamicCast<TcpClientApplication> (clientApps.Get (i));
-	  std::cout << "Client " << i << " Total Bytes Received: " 
-	  					<< client->GetTotalRx () << std::endl;
-  }
+} // namespace ns3
 
-  printf("\nAt end of Simulation:\n");
-  for(int i=0; i<2; i++){
-    Ptr<TcpClientApplication> client = DynamicCast<TcpClientApplication> (clientApps.Get (i));
-    std::cout << "Client " << i << " Total Bytes Received: " 
-              << client->GetCompleteRx () << std::endl;
-  }
+int
+main (int argc, char *argv[])
+{
+  ScenarioConfig config;
+  TcpClientServerBenchmark bench;
+  TcpClientServerSweep sweep;
+
+  bool distributed = false;
+  bool nullmsg = false;
+
+//
+// Allow the user to override any of the defaults at
+// run-time, via command-line arguments
+//
+  CommandLine cmd;
+  AddScenarioOptions (cmd, config);
+  bench.AddOptions (cmd);
+  sweep.AddOptions (cmd);
+  cmd.AddValue ("distributed",
+                "Partition the topology over the MPI ranks (run under mpirun)", distributed);
+  cmd.AddValue ("nullmsg",
+                "Use the null message distributed simulator", nullmsg);
+  cmd.Parse (argc, argv);
+
+  if (bench.IsEnabled ())
+    {
+      return bench.Run (config);
+    }
+  if (sweep.IsEnabled ())
+    {
+      return sweep.Run (config);
+    }
+
+  if (distributed)
+    {
+#ifdef NS3_MPI
+      GlobalValue::Bind ("SimulatorImplementationType",
+                         StringValue (nullmsg ? "ns3::NullMessageSimulatorImpl"
+                                              : "ns3::DistributedSimulatorImpl"));
+      MpiInterface::Enable (&argc, &argv);
+#else
+      NS_FATAL_ERROR ("--distributed needs ns-3 built with MPI (--enable-mpi)");
+#endif
+    }
+
+  RunScenario (config);
+
+#ifdef NS3_MPI
+  if (distributed)
+    {
+      MpiInterface::Disable ();
+    }
+#endif
+  return 0;
 }
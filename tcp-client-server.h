@@ -0,0 +1,109 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef TCP_CLIENT_SERVER_H
+#define TCP_CLIENT_SERVER_H
+
+#include "ns3/command-line.h"
+
+#include <stdint.h>
+#include <string>
+
+namespace ns3 {
+
+/**
+ * \brief Parameters of one run of the tcp-client-server scenario.
+ */
+struct ScenarioConfig
+{
+  ScenarioConfig ();
+
+  std::string tracing;          //!< Trace level: none, summary, sampled or pcap
+  std::string traceFile;        //!< File of the binary flow records
+  std::string fctFile;          //!< File of the FCT histograms, empty for none
+  uint32_t    traceSample;      //!< Record one in this many packets when sampled
+  uint32_t    traceBuffer;      //!< Size of the blocks of flow records written
+  bool        quiet;            //!< Print nothing, only return the result
+  uint64_t    maxBytes;         //!< Size of each transfer
+  double      firstIPchange;    //!< Time of the default address changes
+  std::string mobility;         //!< Address changes, see AddressChangeScheduler
+  std::string mobilityFile;     //!< File of address changes
+  double      mobilitySpread;   //!< Spread of the default address changes
+  std::string topology;         //!< star, dumbbell or multitier
+  uint32_t    numClients;       //!< Number of clients
+  uint32_t    numServers;       //!< Number of servers
+  std::string serverSelection;  //!< ServerSelector Policy of the clients
+  uint32_t    fanOut;           //!< Clients per access router
+  uint32_t    addressPool;      //!< Spare addresses per client
+  std::string accessRate;       //!< Rate of the client links
+  std::string accessDelay;      //!< Delay of the client links
+  std::string bottleneckRate;   //!< Rate of the router and server links
+  std::string bottleneckDelay;  //!< Delay of the router and server links
+  uint32_t    sendSize;         //!< Server write size
+  bool        adaptiveSendSize; //!< Server adaptive write size
+  bool        resume;           //!< Resume transfers after an address change
+  bool        reconnect;        //!< Reconnect on a new socket, with retries
+  uint32_t    numRequests;      //!< Requests per client connection
+  uint32_t    pipelineDepth;    //!< Outstanding requests per client
+  uint32_t    streams;          //!< Parallel connections per client
+  std::string objectSize;       //!< Distribution of the object sizes, see CreateDistribution
+  std::string interArrival;     //!< Distribution of the seconds between requests
+  std::string onTime;           //!< Distribution of the on periods, in seconds
+  std::string offTime;          //!< Distribution of the off periods, in seconds
+  std::string objects;          //!< Distribution of the requested object ids
+  uint64_t    cacheSize;        //!< Bytes of the caching proxy, 0 for none
+  std::string cachePolicy;      //!< Proxy EvictionPolicy: Lru, Lfu or Size
+  uint32_t    maxActive;        //!< Server MaxActiveConnections
+  uint32_t    maxPending;       //!< Server MaxPendingConnections
+  std::string scheduler;        //!< Server Scheduler: Greedy, RoundRobin or Drr
+  uint32_t    quantum;          //!< Server Quantum of the Drr scheduler
+  bool        coalesce;         //!< Server CoalesceRequests
+  std::string flowRate;         //!< Server FlowRate, 0bps for no pacing
+  std::string maxRate;          //!< Server MaxRate, 0bps for no cap
+  uint32_t    pacingBurst;      //!< Server PacingBurst
+  std::string congestionControl; //!< TCP congestion control, empty for the default
+  uint32_t    initialCwnd;      //!< Initial cwnd in segments, 0 for the default
+  uint32_t    sndBufSize;       //!< Socket tx buffer size, 0 for the default
+  uint32_t    rcvBufSize;       //!< Socket rx buffer size, 0 for the default
+  uint32_t    segmentSize;      //!< TCP segment size, 0 for the default
+  double      stopTime;         //!< Simulated duration, in seconds
+  uint32_t    seed;             //!< RngSeedManager seed
+  uint32_t    run;              //!< RngSeedManager run number
+};
+
+/**
+ * \brief Outcome of one run of the scenario.
+ *
+ * Plain data, so that it can be passed through a pipe from a worker
+ * process.
+ */
+struct ScenarioResult
+{
+  double   wallSeconds;         //!< Wall-clock duration of Simulator::Run
+  uint64_t events;              //!< Simulator events processed
+  uint64_t peakRssKb;           //!< Peak resident set size, of the largest rank if distributed
+  uint64_t bytesReceived;       //!< Bytes received by all clients
+  uint64_t completedRequests;   //!< Requests completed by all clients
+  uint64_t serverSendCalls;     //!< Writes made by the server
+  double   meanGoodput;         //!< Mean per-request goodput, in bit/s
+  double   completionP50;       //!< Median request completion time, in s
+  double   completionP99;       //!< 99th percentile completion time, in s
+  double   fairness;            //!< Jain's index of the connection goodputs
+};
+
+/**
+ * \brief Register the scenario parameters as command-line options.
+ * \param cmd the command line
+ * \param config the parameters, updated by cmd.Parse
+ */
+void AddScenarioOptions (CommandLine &cmd, ScenarioConfig &config);
+
+/**
+ * \brief Build the topology, run the simulation and collect its results.
+ * \param config the parameters
+ * \return the results
+ */
+ScenarioResult RunScenario (const ScenarioConfig &config);
+
+} // namespace ns3
+
+#endif /* TCP_CLIENT_SERVER_H */
@@ -0,0 +1,129 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/socket.h"
+#include "tcp-flow-table.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpFlowTable");
+
+TcpFlowTable::TcpFlowTable ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TcpServerFlow *
+TcpFlowTable::Add (Ptr<Socket> socket, const Address &peer)
+{
+  NS_LOG_FUNCTION (this << socket << peer);
+  uint32_t slot;
+  std::unordered_map<const Socket *, uint32_t>::iterator it = m_index.find (PeekPointer (socket));
+  if (it != m_index.end ())
+    {
+      slot = it->second;
+    }
+  else if (!m_free.empty ())
+    {
+      slot = m_free.back ();
+      m_free.pop_back ();
+    }
+  else
+    {
+      slot = m_slots.size ();
+      m_slots.push_back (TcpServerFlow ());
+    }
+  m_index[PeekPointer (socket)] = slot;
+
+  TcpServerFlow &flow = m_slots[slot];
+  flow.socket = socket;
+  flow.peer = peer;
+  flow.bytesSent = 0;
+  flow.bytesRemaining = 0;
+  flow.endless = false;
+  flow.startTime = Simulator::Now ();
+  flow.segmentSize = 0;
+  flow.sessionId = 0;
+  flow.requestId = 0;
+  flow.rxBuffer = 0;
+  flow.pending.clear ();
+  flow.state = TcpServerFlow::IDLE;
+  flow.deficit = 0;
+  flow.scheduled = false;
+  flow.connectionBytes = 0;
+  flow.serverTxAtStart = 0;
+  flow.shared = 0;
+  flow.objectId = 0;
+  flow.objectSize = 0;
+  flow.objectOffset = 0;
+  flow.pacer = TcpTokenBucket ();
+  flow.paceEvent = EventId ();
+  return &flow;
+}
+
+TcpServerFlow *
+TcpFlowTable::Find (Ptr<Socket> socket)
+{
+  std::unordered_map<const Socket *, uint32_t>::iterator it = m_index.find (PeekPointer (socket));
+  if (it == m_index.end ())
+    {
+      return 0;
+    }
+  return &m_slots[it->second];
+}
+
+void
+TcpFlowTable::Remove (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  std::unordered_map<const Socket *, uint32_t>::iterator it = m_index.find (PeekPointer (socket));
+  if (it == m_index.end ())
+    {
+      return;
+    }
+  TcpServerFlow &flow = m_slots[it->second];
+  flow.socket = 0;
+  flow.rxBuffer = 0;
+  flow.pending.clear ();
+  flow.shared = 0;
+  flow.paceEvent.Cancel ();
+  flow.state = TcpServerFlow::DONE;
+  m_free.push_back (it->second);
+  m_index.erase (it);
+}
+
+void
+TcpFlowTable::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (std::vector<TcpServerFlow>::iterator it = m_slots.begin (); it != m_slots.end (); ++it)
+    {
+      it->paceEvent.Cancel ();
+    }
+  m_slots.clear ();
+  m_free.clear ();
+  m_index.clear ();
+}
+
+uint32_t
+TcpFlowTable::GetN (void) const
+{
+  return m_index.size ();
+}
+
+std::list<Ptr<Socket> >
+TcpFlowTable::GetSockets (void) const
+{
+  std::list<Ptr<Socket> > sockets;
+  for (std::vector<TcpServerFlow>::const_iterator it = m_slots.begin (); it != m_slots.end (); ++it)
+    {
+      if (it->socket)
+        {
+          sockets.push_back (it->socket);
+        }
+    }
+  return sockets;
+}
+
+} // namespace ns3
@@ -0,0 +1,122 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef TCP_FLOW_TABLE_H
+#define TCP_FLOW_TABLE_H
+
+#include "ns3/address.h"
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+#include "ns3/packet.h"
+#include "tcp-payload-source.h"
+#include "tcp-request-header.h"
+#include "tcp-token-bucket.h"
+
+#include <stdint.h>
+#include <deque>
+#include <list>
+#include <vector>
+#include <unordered_map>
+
+namespace ns3 {
+
+class Socket;
+
+/**
+ * \ingroup tcpserver
+ * \brief Transfer state of one accepted connection.
+ */
+struct TcpServerFlow
+{
+  /// Life cycle of a flow.
+  enum State
+  {
+    IDLE,       //!< Accepted, waiting for a request
+    SENDING,    //!< Serving a request, payload being sent
+    DONE        //!< All requests served, socket closing
+  };
+
+  Ptr<Socket>   socket;         //!< Accepted socket
+  Address       peer;           //!< Address of the client
+  uint64_t      bytesSent;      //!< Bytes sent for the current request
+  uint64_t      bytesRemaining; //!< Bytes still to send for the current request
+  bool          endless;        //!< The current request has no size limit
+  Time          startTime;      //!< Time the current request was started
+  Time          firstByteTime;  //!< Time the first byte of it was written
+  uint32_t      segmentSize;    //!< TCP segment size of the socket, 0 to write SendSize chunks
+  uint32_t      sessionId;      //!< Session id of the current request
+  uint32_t      requestId;      //!< Id of the current request
+  Ptr<Packet>   rxBuffer;       //!< Received bytes not yet parsed
+  std::deque<TcpRequestHeader> pending; //!< Pipelined requests not yet served
+  State         state;          //!< Current state
+  uint64_t      deficit;        //!< Bytes the scheduler still owes the flow
+  bool          scheduled;      //!< True while in the scheduler's rotation
+  uint64_t      connectionBytes; //!< Bytes sent on the connection
+  uint64_t      serverTxAtStart; //!< Server bytes sent when the flow was admitted
+  Ptr<TcpSharedPayload> shared; //!< Payload of the current object, 0 if not coalesced
+  uint32_t      objectId;       //!< Object id of the current request
+  uint64_t      objectSize;     //!< Object size of the current request
+  uint64_t      objectOffset;   //!< Offset in the object of the next write
+  TcpTokenBucket pacer;         //!< Pacing of the flow's writes
+  EventId       paceEvent;      //!< Wake-up once the pacers have tokens
+};
+
+/**
+ * \ingroup tcpserver
+ * \brief Per-socket session table of a TcpServerApplication.
+ *
+ * Flows live in a contiguous slot vector; freed slots are recycled so the
+ * table never grows past the peak number of concurrent connections.  The
+ * socket to slot index is a hash map, so lookups on the send path are O(1).
+ *
+ * Pointers returned by Find are invalidated by the next Add.
+ */
+class TcpFlowTable
+{
+public:
+  TcpFlowTable ();
+
+  /**
+   * \brief Insert a new flow in state IDLE.
+   * \param socket the accepted socket
+   * \param peer the address of the client
+   * \return the flow
+   */
+  TcpServerFlow *Add (Ptr<Socket> socket, const Address &peer);
+
+  /**
+   * \param socket the accepted socket
+   * \return the flow of the socket, or 0 if unknown
+   */
+  TcpServerFlow *Find (Ptr<Socket> socket);
+
+  /**
+   * \brief Release the slot of a socket, if any.
+   * \param socket the accepted socket
+   */
+  void Remove (Ptr<Socket> socket);
+
+  /**
+   * \brief Remove all flows.
+   */
+  void Clear (void);
+
+  /**
+   * \return the number of flows in the table
+   */
+  uint32_t GetN (void) const;
+
+  /**
+   * \return the sockets of the flows in the table
+   */
+  std::list<Ptr<Socket> > GetSockets (void) const;
+
+private:
+  std::vector<TcpServerFlow> m_slots;                     //!< Flow storage
+  std::vector<uint32_t>      m_free;                      //!< Unused slots
+  std::unordered_map<const Socket *, uint32_t> m_index;   //!< Socket to slot
+};
+
+} // namespace ns3
+
+#endif /* TCP_FLOW_TABLE_H */
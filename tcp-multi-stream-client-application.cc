@@ -0,0 +1,636 @@
+#include "ns3/log.h"
+#include "ns3/address.h"
+#include "ns3/node.h"
+#include "ns3/nstime.h"
+#include "ns3/socket.h"
+#include "ns3/simulator.h"
+#include "ns3/socket-factory.h"
+#include "ns3/packet.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/string.h"
+#include "ns3/trace-source-accessor.h"
+#include "ns3/tcp-socket-factory.h"
+#include "tcp-multi-stream-client-application.h"
+#include "tcp-request-header.h"
+#include "tcp-socket-options.h"
+
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpMultiStreamClientApplication");
+
+NS_OBJECT_ENSURE_REGISTERED (TcpMultiStreamClientApplication);
+
+TypeId
+TcpMultiStreamClientApplication::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TcpMultiStreamClientApplication")
+    .SetParent<Application> ()
+    .SetGroupName("Applications")
+    .AddConstructor<TcpMultiStreamClientApplication> ()
+    .AddAttribute ("Remote", "The address of the first server",
+                   AddressValue (),
+                   MakeAddressAccessor (&TcpMultiStreamClientApplication::m_peer),
+                   MakeAddressChecker ())
+    .AddAttribute ("Streams",
+                   "The number of parallel connections each object is split over.",
+                   UintegerValue (4),
+                   MakeUintegerAccessor (&TcpMultiStreamClientApplication::m_numStreams),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("ObjectSize",
+                   "The size of each downloaded object.",
+                   UintegerValue (1024 * 1024),
+                   MakeUintegerAccessor (&TcpMultiStreamClientApplication::m_objectSize),
+                   MakeUintegerChecker<uint64_t> (1))
+    .AddAttribute ("NumObjects",
+                   "The number of objects downloaded one after the other. "
+                   "More than one needs a Persistent server. "
+                   "The value zero means that there is no limit.",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&TcpMultiStreamClientApplication::m_numObjects),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Resume",
+                   "If true, a reconnection asks the server for the rest of "
+                   "each range instead of starting the object over.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpMultiStreamClientApplication::m_resume),
+                   MakeBooleanChecker ())
+    .AddAttribute ("SessionId",
+                   "The session id sent in requests. "
+                   "The value zero picks a unique id from the node id "
+                   "and the application index.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&TcpMultiStreamClientApplication::m_sessionId),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MaxConnectAttempts",
+                   "The connection attempts after which a stream gives up. "
+                   "The value zero means that there is no limit.",
+                   UintegerValue (8),
+                   MakeUintegerAccessor (&TcpMultiStreamClientApplication::m_maxAttempts),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("ImmediateRetries",
+                   "The failed attempts retried at once, before backing off.",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&TcpMultiStreamClientApplication::m_immediateRetries),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("InitialBackoff",
+                   "The delay before the first backed off retry; "
+                   "it doubles with every further failure.",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&TcpMultiStreamClientApplication::m_initialBackoff),
+                   MakeTimeChecker ())
+    .AddAttribute ("MaxBackoff",
+                   "The largest delay between two retries.",
+                   TimeValue (Seconds (5)),
+                   MakeTimeAccessor (&TcpMultiStreamClientApplication::m_maxBackoff),
+                   MakeTimeChecker ())
+    .AddAttribute ("ConnTimeout",
+                   "The SYN retransmission timeout of the sockets.",
+                   TimeValue (Seconds (3)),
+                   MakeTimeAccessor (&TcpMultiStreamClientApplication::m_connTimeout),
+                   MakeTimeChecker ())
+    .AddAttribute ("ConnCount",
+                   "The SYN retransmissions of the sockets before the "
+                   "attempt fails.",
+                   UintegerValue (6),
+                   MakeUintegerAccessor (&TcpMultiStreamClientApplication::m_connCount),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("CongestionControl",
+                   "TypeId name of the TCP congestion control of the sockets, "
+                   "e.g. ns3::TcpCubic. Empty for the node's default.",
+                   StringValue (""),
+                   MakeStringAccessor (&TcpMultiStreamClientApplication::m_congestionControl),
+                   MakeStringChecker ())
+    .AddAttribute ("InitialCwnd",
+                   "Initial congestion window of the sockets, in segments. "
+                   "The value zero keeps the TcpSocket default.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&TcpMultiStreamClientApplication::m_initialCwnd),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("SndBufSize",
+                   "Tx buffer size of the sockets, in bytes. "
+                   "The value zero keeps the TcpSocket default.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&TcpMultiStreamClientApplication::m_sndBufSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("RcvBufSize",
+                   "Rx buffer size of the sockets, in bytes. "
+                   "The value zero keeps the TcpSocket default.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&TcpMultiStreamClientApplication::m_rcvBufSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("SegmentSize",
+                   "TCP maximum segment size of the sockets, in bytes. "
+                   "The value zero keeps the TcpSocket default.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&TcpMultiStreamClientApplication::m_segmentSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddTraceSource ("Tx", "A range request is sent",
+                     MakeTraceSourceAccessor (&TcpMultiStreamClientApplication::m_txTrace),
+                     "ns3::Packet::TracedCallback")
+    .AddTraceSource ("RxBatch",
+                     "A socket has been drained: bytes, packets, peer",
+                     MakeTraceSourceAccessor (&TcpMultiStreamClientApplication::m_rxBatchTrace),
+                     "ns3::TcpClientApplication::RxBatchTracedCallback")
+    .AddTraceSource ("TransferComplete",
+                     "An object has been fully downloaded: "
+                     "object index, bytes, time to first and to last byte",
+                     MakeTraceSourceAccessor (&TcpMultiStreamClientApplication::m_transferTrace),
+                     "ns3::TcpTransferStats::TransferTracedCallback")
+  ;
+  return tid;
+}
+
+
+TcpMultiStreamClientApplication::TcpMultiStreamClientApplication ()
+  : m_object (0),
+    m_objectActive (false),
+    m_rangesLeft (0),
+    m_objectStarted (false),
+    m_completeRx (0),
+    m_resumedBytes (0),
+    m_completedObjects (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TcpMultiStreamClientApplication::~TcpMultiStreamClientApplication ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+TcpMultiStreamClientApplication::AddRemote (const Address &remote)
+{
+  NS_LOG_FUNCTION (this << remote);
+  m_remotes.push_back (remote);
+}
+
+uint64_t TcpMultiStreamClientApplication::GetTotalRx () const
+{
+  uint64_t total = 0;
+  for (uint32_t i = 0; i < m_streams.size (); i++)
+    {
+      total += m_streams[i].totalRx;
+    }
+  return total;
+}
+
+uint64_t TcpMultiStreamClientApplication::GetCompleteRx () const
+{
+  return m_completeRx;
+}
+
+uint64_t TcpMultiStreamClientApplication::GetResumedBytes () const
+{
+  return m_resumedBytes;
+}
+
+uint32_t TcpMultiStreamClientApplication::GetCompletedRequests () const
+{
+  return m_completedObjects;
+}
+
+const TcpTransferStats &
+TcpMultiStreamClientApplication::GetStats () const
+{
+  return m_stats;
+}
+
+uint32_t
+TcpMultiStreamClientApplication::GetNStreams () const
+{
+  return m_streams.size ();
+}
+
+const TcpTransferStats &
+TcpMultiStreamClientApplication::GetStreamStats (uint32_t i) const
+{
+  return m_streams.at (i).stats;
+}
+
+void
+TcpMultiStreamClientApplication::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t i = 0; i < m_streams.size (); i++)
+    {
+      Simulator::Cancel (m_streams[i].retryEvent);
+    }
+  m_streams.clear ();
+  Application::DoDispose ();
+}
+
+void TcpMultiStreamClientApplication::StartApplication (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_sessionId == 0)
+    {
+      // Same rule as TcpClientApplication, see there
+      uint32_t index = 0;
+      while (index < GetNode ()->GetNApplications ()
+             && GetNode ()->GetApplication (index) != this)
+        {
+          index++;
+        }
+      m_sessionId = (GetNode ()->GetId () << 8) + index + 1;
+    }
+
+  if (m_streams.empty ())
+    {
+      m_remotes.insert (m_remotes.begin (), m_peer);
+      m_streams.resize (m_numStreams);
+      for (uint32_t i = 0; i < m_streams.size (); i++)
+        {
+          Stream &stream = m_streams[i];
+          stream.peer = m_remotes[i % m_remotes.size ()];
+          stream.connected = false;
+          stream.active = false;
+          stream.sent = false;
+          stream.started = false;
+          stream.size = 0;
+          stream.received = 0;
+          stream.totalRx = 0;
+          stream.attempts = 0;
+          OpenSocket (i);
+        }
+    }
+  StartObject ();
+}
+
+void TcpMultiStreamClientApplication::StopApplication (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t i = 0; i < m_streams.size (); i++)
+    {
+      Simulator::Cancel (m_streams[i].retryEvent);
+      m_streams[i].socket->Close ();
+      m_streams[i].connected = false;
+    }
+}
+
+void TcpMultiStreamClientApplication::StartConnection (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_streams.empty ())
+    { // not started yet
+      return;
+    }
+  for (uint32_t i = 0; i < m_streams.size (); i++)
+    {
+      Stream &stream = m_streams[i];
+      Simulator::Cancel (stream.retryEvent);
+      stream.connected = false;
+      stream.sent = false;
+      if (!m_resume && stream.active)
+        { // start the range over
+          m_completeRx -= stream.received;
+          stream.received = 0;
+        }
+      stream.attempts = 0;
+      OpenSocket (i);
+    }
+}
+
+// Private helpers
+
+TcpMultiStreamClientApplication::Stream *
+TcpMultiStreamClientApplication::FindStream (Ptr<Socket> socket)
+{
+  for (uint32_t i = 0; i < m_streams.size (); i++)
+    {
+      if (m_streams[i].socket == socket)
+        {
+          return &m_streams[i];
+        }
+    }
+  return 0;
+}
+
+void TcpMultiStreamClientApplication::OpenSocket (uint32_t i)
+{
+  NS_LOG_FUNCTION (this << i);
+  Stream &stream = m_streams[i];
+  if (stream.socket)
+    {
+      // The old connection may be bound to an old address; whatever still
+      // comes on it is of no use
+      stream.socket->SetConnectCallback (MakeNullCallback<void, Ptr<Socket> > (),
+                                         MakeNullCallback<void, Ptr<Socket> > ());
+      stream.socket->SetSendCallback (MakeNullCallback<void, Ptr<Socket>, uint32_t> ());
+      stream.socket->SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
+      stream.socket->SetCloseCallbacks (MakeNullCallback<void, Ptr<Socket> > (),
+                                        MakeNullCallback<void, Ptr<Socket> > ());
+      stream.socket->Close ();
+    }
+  stream.connected = false;
+  stream.sent = false;
+  ++stream.attempts;
+  stream.socket = Socket::CreateSocket (GetNode (), TcpSocketFactory::GetTypeId ());
+  // Fatal error if socket type is not NS3_SOCK_STREAM or NS3_SOCK_SEQPACKET
+  if (stream.socket->GetSocketType () != Socket::NS3_SOCK_STREAM &&
+      stream.socket->GetSocketType () != Socket::NS3_SOCK_SEQPACKET)
+    {
+      NS_FATAL_ERROR ("Use TCP instead of UDP.");
+    }
+  stream.socket->SetAttribute ("ConnTimeout", TimeValue (m_connTimeout));
+  stream.socket->SetAttribute ("ConnCount", UintegerValue (m_connCount));
+  ConfigureTcpSocket (stream.socket, m_congestionControl, m_initialCwnd,
+                      m_sndBufSize, m_rcvBufSize, m_segmentSize);
+  // Bound to no address in particular, the socket takes the source
+  // address of the route to the peer, i.e. the current one
+  stream.socket->Bind ();
+  stream.socket->Connect (stream.peer);
+  stream.socket->SetConnectCallback (
+    MakeCallback (&TcpMultiStreamClientApplication::ConnectionSucceeded, this),
+    MakeCallback (&TcpMultiStreamClientApplication::ConnectionFailed, this));
+  stream.socket->SetSendCallback (
+    MakeCallback (&TcpMultiStreamClientApplication::DataSend, this));
+  stream.socket->SetRecvCallback (
+    MakeCallback (&TcpMultiStreamClientApplication::HandleRead, this));
+  stream.socket->SetCloseCallbacks (
+    MakeCallback (&TcpMultiStreamClientApplication::PeerClosed, this),
+    MakeCallback (&TcpMultiStreamClientApplication::ConnectionError, this));
+  NS_LOG_INFO ("Session " << m_sessionId << " stream " << i << " connection attempt "
+               << stream.attempts << " at " << Simulator::Now ().GetSeconds () << "s");
+}
+
+void TcpMultiStreamClientApplication::RetryConnection (uint32_t i)
+{
+  NS_LOG_FUNCTION (this << i);
+  Stream &stream = m_streams[i];
+  if (m_maxAttempts > 0 && stream.attempts >= m_maxAttempts)
+    {
+      NS_LOG_WARN ("Session " << m_sessionId << " stream " << i << " gives up after "
+                   << stream.attempts << " connection attempts");
+      return;
+    }
+  Time delay;
+  if (stream.attempts > m_immediateRetries)
+    {
+      uint32_t backoffs = std::min<uint32_t> (stream.attempts - m_immediateRetries - 1, 30);
+      delay = Min (m_initialBackoff * static_cast<int64_t> (1 << backoffs), m_maxBackoff);
+    }
+  // Not from within the callback of the failed socket
+  stream.retryEvent = Simulator::Schedule (delay, &TcpMultiStreamClientApplication::OpenSocket,
+                                           this, i);
+}
+
+void TcpMultiStreamClientApplication::StartObject (void)
+{
+  NS_LOG_FUNCTION (this << m_object);
+  if (m_objectActive || (m_numObjects > 0 && m_object >= m_numObjects))
+    {
+      return;
+    }
+  m_objectActive = true;
+  m_objectStarted = false;
+  m_objectStart = Simulator::Now ();
+  m_rangesLeft = 0;
+  // Equal ranges, the first ones one byte longer for the remainder
+  uint64_t base = m_objectSize / m_streams.size ();
+  uint64_t remainder = m_objectSize % m_streams.size ();
+  for (uint32_t i = 0; i < m_streams.size (); i++)
+    {
+      Stream &stream = m_streams[i];
+      stream.size = base + (i < remainder ? 1 : 0);
+      stream.received = 0;
+      stream.sent = false;
+      stream.started = false;
+      stream.active = stream.size > 0;
+      if (stream.active)
+        {
+          ++m_rangesLeft;
+        }
+    }
+  for (uint32_t i = 0; i < m_streams.size (); i++)
+    {
+      SendRange (i);
+    }
+}
+
+void TcpMultiStreamClientApplication::SendRange (uint32_t i)
+{
+  Stream &stream = m_streams[i];
+  if (!stream.connected || !stream.active || stream.sent)
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this << i);
+  TcpRequestHeader request;
+  request.SetSessionId (m_sessionId);
+  request.SetRequestId (m_object * m_streams.size () + i);
+  request.SetObjectSize (stream.size);
+  request.SetOffset (stream.received);
+  NS_LOG_LOGIC ("stream " << i << " sending request " << request << " at " << Simulator::Now ());
+  Ptr<Packet> packet = Create<Packet> ();
+  packet->AddHeader (request);
+  m_txTrace (packet);
+  if (stream.socket->Send (packet) <= 0)
+    { // DataSend tries again once the tx buffer has room
+      return;
+    }
+  if (stream.received > 0)
+    {
+      NS_LOG_INFO ("Session " << m_sessionId << " stream " << i << " resumes object "
+                   << m_object << " at offset " << stream.received);
+      m_resumedBytes += stream.received;
+    }
+  stream.sent = true;
+}
+
+void TcpMultiStreamClientApplication::HandleRead (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  Stream *stream = FindStream (socket);
+  if (!stream)
+    {
+      return;
+    }
+  Ptr<Packet> packet;
+  Address from;
+  uint32_t bytes = 0;
+  uint32_t packets = 0;
+  while ((packet = socket->RecvFrom (from)))
+    {
+      uint32_t size = packet->GetSize ();
+      if (size == 0)
+        { //EOF
+          break;
+        }
+      bytes += size;
+      ++packets;
+    }
+  if (packets == 0)
+    {
+      return;
+    }
+  stream->totalRx += bytes;
+  m_rxBatchTrace (bytes, packets, from);
+  if (!stream->active)
+    {
+      NS_LOG_WARN ("Stream received " << bytes << " bytes with no range outstanding");
+      return;
+    }
+
+  Time now = Simulator::Now ();
+  if (!m_objectStarted)
+    {
+      m_objectFirstByte = now;
+      m_objectStarted = true;
+    }
+  if (!stream->started)
+    {
+      stream->firstByte = now;
+      stream->started = true;
+    }
+  uint64_t part = std::min<uint64_t> (bytes, stream->size - stream->received);
+  stream->received += part;
+  m_completeRx += part;
+  if (stream->received < stream->size)
+    {
+      return;
+    }
+
+  stream->active = false;
+  stream->stats.Add (stream->size, stream->firstByte - m_objectStart, now - m_objectStart);
+  if (--m_rangesLeft > 0)
+    {
+      return;
+    }
+  NS_LOG_INFO ("Object " << m_object << " of session " << m_sessionId
+               << " complete at " << now.GetSeconds () << "s");
+  Time firstByte = m_objectFirstByte - m_objectStart;
+  Time completion = now - m_objectStart;
+  m_stats.Add (m_objectSize, firstByte, completion);
+  m_transferTrace (m_object, m_objectSize, firstByte, completion);
+  ++m_completedObjects;
+  ++m_object;
+  m_objectActive = false;
+  StartObject ();
+}
+
+void TcpMultiStreamClientApplication::ConnectionSucceeded (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  Stream *stream = FindStream (socket);
+  if (stream)
+    {
+      stream->connected = true;
+      SendRange (stream - &m_streams[0]);
+    }
+}
+
+void TcpMultiStreamClientApplication::ConnectionFailed (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  NS_LOG_LOGIC ("TcpMultiStreamClientApplication, Connection Failed");
+  Stream *stream = FindStream (socket);
+  if (stream)
+    {
+      RetryConnection (stream - &m_streams[0]);
+    }
+}
+
+void TcpMultiStreamClientApplication::ConnectionError (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  Stream *stream = FindStream (socket);
+  if (!stream || !stream->connected)
+    { // a failed attempt is ConnectionFailed's
+      return;
+    }
+  uint32_t i = stream - &m_streams[0];
+  NS_LOG_INFO ("Session " << m_sessionId << " stream " << i << " connection reset at "
+               << Simulator::Now ().GetSeconds () << "s");
+  stream->connected = false;
+  stream->sent = false;
+  if (!m_resume && stream->active)
+    { // start the range over
+      m_completeRx -= stream->received;
+      stream->received = 0;
+    }
+  stream->attempts = 0;
+  RetryConnection (i);
+}
+
+void TcpMultiStreamClientApplication::PeerClosed (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  Stream *stream = FindStream (socket);
+  if (!stream)
+    {
+      return;
+    }
+  if (stream->connected && stream->active)
+    { // closed before the range was complete: ask for the rest again
+      ConnectionError (socket);
+    }
+  stream->connected = false;
+  // A non-persistent server keeps the connection counted until we close
+  // our side
+  socket->Close ();
+}
+
+void TcpMultiStreamClientApplication::DataSend (Ptr<Socket> socket, uint32_t)
+{
+  NS_LOG_FUNCTION (this << socket);
+  Stream *stream = FindStream (socket);
+  if (stream)
+    {
+      SendRange (stream - &m_streams[0]);
+    }
+}
+
+/************************************************************************************/
+
+TcpMultiStreamClientApplicationHelper::TcpMultiStreamClientApplicationHelper (Address address)
+{
+  m_factory.SetTypeId (TcpMultiStreamClientApplication::GetTypeId ());
+  SetAttribute ("Remote", AddressValue (address));
+}
+
+void
+TcpMultiStreamClientApplicationHelper::SetAttribute (std::string name, const AttributeValue &value)
+{
+  m_factory.Set (name, value);
+}
+
+void
+TcpMultiStreamClientApplicationHelper::AddRemote (Address address)
+{
+  m_remotes.push_back (address);
+}
+
+ApplicationContainer
+TcpMultiStreamClientApplicationHelper::Install (Ptr<Node> node) const
+{
+  return ApplicationContainer (InstallPriv (node));
+}
+
+ApplicationContainer
+TcpMultiStreamClientApplicationHelper::Install (NodeContainer c) const
+{
+  ApplicationContainer apps;
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      apps.Add (InstallPriv (*i));
+    }
+  return apps;
+}
+
+Ptr<Application>
+TcpMultiStreamClientApplicationHelper::InstallPriv (Ptr<Node> node) const
+{
+  Ptr<TcpMultiStreamClientApplication> app = m_factory.Create<TcpMultiStreamClientApplication> ();
+  for (uint32_t i = 0; i < m_remotes.size (); i++)
+    {
+      app->AddRemote (m_remotes[i]);
+    }
+  node->AddApplication (app);
+  return app;
+}
+
+} // Namespace ns3
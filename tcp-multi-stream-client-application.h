@@ -0,0 +1,265 @@
+#ifndef TCP_MULTI_STREAM_CLIENT_APPLICATION_H
+#define TCP_MULTI_STREAM_CLIENT_APPLICATION_H
+
+#include "ns3/address.h"
+#include "ns3/application.h"
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+#include "ns3/traced-callback.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "ns3/attribute.h"
+#include "ns3/node-container.h"
+#include "ns3/application-container.h"
+#include "tcp-transfer-stats.h"
+
+namespace ns3 {
+
+class Address;
+class Socket;
+class Packet;
+
+/**
+ * \ingroup clientsend
+ * \brief Downloads each object over several parallel connections.
+ *
+ * Opens Streams connections, spread over the remotes (Remote plus those
+ * given to AddRemote), and splits every object of ObjectSize bytes into
+ * one byte range per connection.  A range is requested as an object of
+ * the size of the range, so any TcpServerApplication serves it; after a
+ * reconnection with Resume set, the offset of the request skips what the
+ * range already received.  The next object is requested once every
+ * range of the current one has arrived.
+ *
+ * Like a RecreateSocket TcpClientApplication, every connection attempt
+ * uses a new socket bound to the current address of the node, and a
+ * failed or reset connection is retried with the same backoff.
+ *
+ * The statistics of the objects are those of the whole download, from
+ * the request of the first range to the last byte of the last one; the
+ * statistics of each connection are kept apart to study fairness.
+ */
+class TcpMultiStreamClientApplication : public Application
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  TcpMultiStreamClientApplication ();
+
+  virtual ~TcpMultiStreamClientApplication ();
+
+  /**
+   * \brief Spread the connections over one more server.
+   * \param remote the address of the server
+   */
+  void AddRemote (const Address &remote);
+
+  /**
+   * \return the bytes received on all the connections
+   */
+  uint64_t GetTotalRx () const;
+  /**
+   * \return the bytes of ranges received on all connections
+   */
+  uint64_t GetCompleteRx () const;
+  /**
+   * \return the bytes not requested again thanks to Resume
+   */
+  uint64_t GetResumedBytes () const;
+  /**
+   * \return the number of objects fully downloaded
+   */
+  uint32_t GetCompletedRequests () const;
+  /**
+   * \return the statistics of the downloaded objects
+   */
+  const TcpTransferStats &GetStats () const;
+  /**
+   * \return the number of connections
+   */
+  uint32_t GetNStreams () const;
+  /**
+   * \param i the connection index
+   * \return the statistics of the ranges received on connection i, timed
+   * from the request of their object
+   */
+  const TcpTransferStats &GetStreamStats (uint32_t i) const;
+
+  /**
+   * \brief Connect all the streams again, e.g. after the address of the
+   * node changed.
+   */
+  void StartConnection (void);
+
+protected:
+  virtual void DoDispose (void);
+private:
+  // inherited from Application base class.
+  virtual void StartApplication (void);    // Called at time specified by Start
+  virtual void StopApplication (void);     // Called at time specified by Stop
+
+  /// One of the parallel connections and its range of the current object
+  struct Stream
+  {
+    Ptr<Socket> socket;     //!< Associated socket
+    Address     peer;       //!< Server of this connection
+    bool        connected;  //!< True if connected
+    bool        active;     //!< True while its range is not complete
+    bool        sent;       //!< True once the range was requested on this connection
+    bool        started;    //!< True once the first byte of the range arrived
+    uint64_t    size;       //!< Size of the range
+    uint64_t    received;   //!< Bytes of the range received so far
+    uint64_t    totalRx;    //!< Bytes received on all its connections
+    Time        firstByte;  //!< Time the first byte of the range arrived
+    TcpTransferStats stats; //!< Statistics of the completed ranges
+    EventId     retryEvent; //!< Next connection attempt
+    uint32_t    attempts;   //!< Connection attempts since the last (re)connection
+  };
+
+  /**
+   * \param socket a socket of the application
+   * \return the stream of the socket
+   */
+  Stream *FindStream (Ptr<Socket> socket);
+  /**
+   * \brief Close the socket of a stream, if any, and connect a new one.
+   * \param i the stream index
+   */
+  void OpenSocket (uint32_t i);
+  /**
+   * \brief Open a new socket for a stream after an immediate retry or a
+   * backoff, unless MaxConnectAttempts attempts failed.
+   * \param i the stream index
+   */
+  void RetryConnection (uint32_t i);
+  /**
+   * \brief Split the next object into ranges and request them.
+   */
+  void StartObject (void);
+  /**
+   * \brief Request the range of a stream, if it is connected and has not
+   * requested it yet.
+   * \param i the stream index
+   */
+  void SendRange (uint32_t i);
+
+  void HandleRead (Ptr<Socket> socket);
+  void ConnectionSucceeded (Ptr<Socket> socket);
+  void ConnectionFailed (Ptr<Socket> socket);
+  /**
+   * \brief The connection of a stream was reset.
+   * \param socket the socket
+   */
+  void ConnectionError (Ptr<Socket> socket);
+  /**
+   * \brief The server closed the connection of a stream; close our side
+   * too, so that the server can let it go.
+   * \param socket the socket
+   */
+  void PeerClosed (Ptr<Socket> socket);
+  void DataSend (Ptr<Socket> socket, uint32_t available);
+
+  Address         m_peer;         //!< First server
+  std::vector<Address> m_remotes; //!< Servers the streams are spread over
+  uint32_t        m_numStreams;   //!< Number of parallel connections
+  uint64_t        m_objectSize;   //!< Size of each object
+  uint32_t        m_numObjects;   //!< Objects to download, 0 for no limit
+  bool            m_resume;       //!< Resume the ranges after reconnecting
+  uint32_t        m_sessionId;    //!< Session id sent in requests
+  uint32_t        m_maxAttempts;  //!< Attempts before giving up, 0 for no limit
+  uint32_t        m_immediateRetries; //!< Retries without backoff
+  Time            m_initialBackoff; //!< Delay of the first backed off retry
+  Time            m_maxBackoff;   //!< Largest delay between retries
+  Time            m_connTimeout;  //!< SYN retransmission timeout of new sockets
+  uint32_t        m_connCount;    //!< SYN retransmissions of new sockets
+  std::string     m_congestionControl; //!< Congestion control of the sockets, empty for the default
+  uint32_t        m_initialCwnd;  //!< Initial cwnd of the sockets in segments, 0 for the default
+  uint32_t        m_sndBufSize;   //!< Tx buffer size of the sockets, 0 for the default
+  uint32_t        m_rcvBufSize;   //!< Rx buffer size of the sockets, 0 for the default
+  uint32_t        m_segmentSize;  //!< Segment size of the sockets, 0 for the default
+  std::vector<Stream> m_streams;  //!< The parallel connections
+
+  uint32_t        m_object;       //!< Index of the current object
+  bool            m_objectActive; //!< True while the current object is downloaded
+  uint32_t        m_rangesLeft;   //!< Ranges of the current object not complete
+  Time            m_objectStart;  //!< Time the current object was requested
+  Time            m_objectFirstByte; //!< Time its first byte arrived
+  bool            m_objectStarted;   //!< True once its first byte arrived
+  uint64_t        m_completeRx;   //!< Bytes of ranges received
+  uint64_t        m_resumedBytes; //!< Bytes not requested again on reconnection
+  uint32_t        m_completedObjects; //!< Objects fully downloaded
+  TcpTransferStats m_stats;       //!< Statistics of the downloaded objects
+
+  /// Traced Callback: sent requests
+  TracedCallback<Ptr<const Packet> > m_txTrace;
+  /// Traced Callback: bytes and packets drained by one HandleRead, source address.
+  TracedCallback<uint32_t, uint32_t, const Address &> m_rxBatchTrace;
+  /// Traced Callback: an object has been fully downloaded.
+  TracedCallback<uint32_t, uint64_t, Time, Time> m_transferTrace;
+};
+
+class TcpMultiStreamClientApplicationHelper
+{
+public:
+  /**
+   * Create a TcpMultiStreamClientApplicationHelper to make it easier to
+   * work with TcpMultiStreamClientApplications
+   *
+   * \param address the address of the first server
+   */
+  TcpMultiStreamClientApplicationHelper (Address address);
+
+  /**
+   * Helper function used to set the underlying application attributes,
+   * _not_ the socket attributes.
+   *
+   * \param name the name of the application attribute to set
+   * \param value the value of the application attribute to set
+   */
+  void SetAttribute (std::string name, const AttributeValue &value);
+
+  /**
+   * \param address the address of one more server the installed
+   * applications spread their connections over
+   */
+  void AddRemote (Address address);
+
+  /**
+   * Install an ns3::TcpMultiStreamClientApplication on each node of the
+   * input container configured with all the attributes set with SetAttribute.
+   *
+   * \param c NodeContainer of the set of nodes
+   * \returns Container of Ptr to the applications installed.
+   */
+  ApplicationContainer Install (NodeContainer c) const;
+
+  /**
+   * Install an ns3::TcpMultiStreamClientApplication on the node configured
+   * with all the attributes set with SetAttribute.
+   *
+   * \param node The node on which the application will be installed.
+   * \returns Container of Ptr to the applications installed.
+   */
+  ApplicationContainer Install (Ptr<Node> node) const;
+
+private:
+  /**
+   * \param node The node on which the application will be installed.
+   * \returns Ptr to the application installed.
+   */
+  Ptr<Application> InstallPriv (Ptr<Node> node) const;
+
+  ObjectFactory m_factory;        //!< Object factory.
+  std::vector<Address> m_remotes; //!< Servers added with AddRemote
+};
+
+} // namespace ns3
+
+#endif /* TCP_MULTI_STREAM_CLIENT_APPLICATION_H */
@@ -0,0 +1,117 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "ns3/packet.h"
+#include "tcp-payload-source.h"
+
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpPayloadSource");
+
+TcpPayloadSource::TcpPayloadSource (uint32_t blockSize)
+{
+  NS_LOG_FUNCTION (this << blockSize);
+  m_block = Create<Packet> (blockSize);
+}
+
+Ptr<Packet>
+TcpPayloadSource::Get (uint32_t size)
+{
+  if (size > m_block->GetSize ())
+    {
+      NS_LOG_LOGIC ("growing payload block to " << size << " bytes");
+      m_block = Create<Packet> (size);
+      m_templates.clear ();
+    }
+  for (std::vector<Ptr<Packet> >::const_iterator it = m_templates.begin ();
+       it != m_templates.end (); ++it)
+    {
+      if ((*it)->GetSize () == size)
+        {
+          return (*it)->Copy ();
+        }
+    }
+  if (m_templates.size () < MAX_TEMPLATES)
+    {
+      m_templates.push_back (m_block->CreateFragment (0, size));
+      return m_templates.back ()->Copy ();
+    }
+  return m_block->CreateFragment (0, size);
+}
+
+uint32_t
+TcpPayloadSource::GetBlockSize (void) const
+{
+  return m_block->GetSize ();
+}
+
+const uint32_t TcpSharedPayload::CHUNK_SIZE;
+
+TcpSharedPayload::TcpSharedPayload (Ptr<TcpPayloadSource> source, uint64_t size)
+  : m_source (source),
+    m_size (size),
+    m_chunks ((size + CHUNK_SIZE - 1) / CHUNK_SIZE),
+    m_readers (0),
+    m_built (0),
+    m_served (0)
+{
+  NS_LOG_FUNCTION (this << size);
+}
+
+uint32_t
+TcpSharedPayload::GetContiguous (uint64_t offset) const
+{
+  if (offset >= m_size)
+    {
+      return 0;
+    }
+  uint64_t chunkEnd = std::min (m_size, (offset / CHUNK_SIZE + 1) * CHUNK_SIZE);
+  return static_cast<uint32_t> (chunkEnd - offset);
+}
+
+Ptr<Packet>
+TcpSharedPayload::Get (uint64_t offset, uint32_t size)
+{
+  NS_ASSERT_MSG (size <= GetContiguous (offset), "Payload crosses a chunk boundary");
+  uint64_t index = offset / CHUNK_SIZE;
+  Ptr<Packet> &chunk = m_chunks[index];
+  if (!chunk)
+    {
+      uint32_t chunkSize = static_cast<uint32_t> (
+          std::min<uint64_t> (CHUNK_SIZE, m_size - index * CHUNK_SIZE));
+      NS_LOG_LOGIC ("building chunk " << index << " of " << chunkSize << " bytes");
+      chunk = m_source->Get (chunkSize);
+      m_built += chunkSize;
+    }
+  m_served += size;
+  return chunk->CreateFragment (static_cast<uint32_t> (offset - index * CHUNK_SIZE), size);
+}
+
+void
+TcpSharedPayload::AddReader (void)
+{
+  ++m_readers;
+}
+
+uint32_t
+TcpSharedPayload::RemoveReader (void)
+{
+  NS_ASSERT (m_readers > 0);
+  return --m_readers;
+}
+
+uint64_t
+TcpSharedPayload::GetBuiltBytes (void) const
+{
+  return m_built;
+}
+
+uint64_t
+TcpSharedPayload::GetServedBytes (void) const
+{
+  return m_served;
+}
+
+} // namespace ns3
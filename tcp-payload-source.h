@@ -0,0 +1,123 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef TCP_PAYLOAD_SOURCE_H
+#define TCP_PAYLOAD_SOURCE_H
+
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+class Packet;
+
+/**
+ * \ingroup tcpserver
+ * \brief Hands out payload packets cut from one pre-built block.
+ *
+ * Create<Packet> (size) allocates a packet, its buffer and its metadata for
+ * every chunk.  This source builds one block up front, plus a template for
+ * each of the few chunk sizes seen most (typically just SendSize and the
+ * tail of a transfer), and returns copies of them.  A copy shares the
+ * buffer of its template, so a chunk costs a single Packet object.
+ *
+ * The returned packets are distinct objects on purpose: TcpTxBuffer keeps
+ * and merges the packets handed to Socket::Send, so the same object cannot
+ * be sent twice.
+ */
+class TcpPayloadSource : public SimpleRefCount<TcpPayloadSource>
+{
+public:
+  /**
+   * \param blockSize size of the pre-built block; larger requests grow it
+   */
+  TcpPayloadSource (uint32_t blockSize);
+
+  /**
+   * \param size the payload size
+   * \return a new packet of size bytes
+   */
+  Ptr<Packet> Get (uint32_t size);
+
+  /**
+   * \return the size of the pre-built block
+   */
+  uint32_t GetBlockSize (void) const;
+
+private:
+  /// Maximum number of per-size templates kept
+  static const uint32_t MAX_TEMPLATES = 4;
+
+  Ptr<Packet>               m_block;     //!< Pre-built payload block
+  std::vector<Ptr<Packet> > m_templates; //!< Pre-built chunks, one per size
+};
+
+/**
+ * \ingroup tcpserver
+ * \brief Payload of one object, shared by the responses that send it at
+ * the same time.
+ *
+ * The object is cut into chunks of CHUNK_SIZE bytes, each taken from the
+ * TcpPayloadSource the first time a reader gets to it and kept while the
+ * object has readers.  Every write is a fragment of a chunk, which shares
+ * the chunk's buffer, so the payload is built once per object and its
+ * memory does not grow with the number of readers.
+ */
+class TcpSharedPayload : public SimpleRefCount<TcpSharedPayload>
+{
+public:
+  /// Size of the chunks the object is cut into
+  static const uint32_t CHUNK_SIZE = 65536;
+
+  /**
+   * \param source where the chunks are taken from
+   * \param size the size of the object
+   */
+  TcpSharedPayload (Ptr<TcpPayloadSource> source, uint64_t size);
+
+  /**
+   * \param offset an offset in the object
+   * \return the bytes from offset to the end of its chunk, the most a
+   * single Get can return
+   */
+  uint32_t GetContiguous (uint64_t offset) const;
+  /**
+   * \param offset the offset of the payload in the object
+   * \param size the payload size, at most GetContiguous (offset)
+   * \return a new packet of size bytes
+   */
+  Ptr<Packet> Get (uint64_t offset, uint32_t size);
+
+  /**
+   * \brief Count a response that sends the object.
+   */
+  void AddReader (void);
+  /**
+   * \brief Count a response done with the object.
+   * \return the number of responses still sending it
+   */
+  uint32_t RemoveReader (void);
+
+  /**
+   * \return the bytes taken from the source
+   */
+  uint64_t GetBuiltBytes (void) const;
+  /**
+   * \return the bytes handed out by Get
+   */
+  uint64_t GetServedBytes (void) const;
+
+private:
+  Ptr<TcpPayloadSource>     m_source;  //!< Source of the chunks
+  uint64_t                  m_size;    //!< Object size
+  std::vector<Ptr<Packet> > m_chunks;  //!< Chunks, 0 until first read
+  uint32_t                  m_readers; //!< Responses sending the object
+  uint64_t                  m_built;   //!< Bytes taken from the source
+  uint64_t                  m_served;  //!< Bytes handed out
+};
+
+} // namespace ns3
+
+#endif /* TCP_PAYLOAD_SOURCE_H */
@@ -0,0 +1,135 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "tcp-request-header.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpRequestHeader");
+
+NS_OBJECT_ENSURE_REGISTERED (TcpRequestHeader);
+
+TcpRequestHeader::TcpRequestHeader ()
+  : m_sessionId (0),
+    m_requestId (0),
+    m_objectId (0),
+    m_objectSize (0),
+    m_offset (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId
+TcpRequestHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TcpRequestHeader")
+    .SetParent<Header> ()
+    .SetGroupName("Applications")
+    .AddConstructor<TcpRequestHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+TcpRequestHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+TcpRequestHeader::Print (std::ostream &os) const
+{
+  os << "(session=" << m_sessionId << " request=" << m_requestId
+     << " object=" << m_objectId << " size=" << m_objectSize << " offset=" << m_offset << ")";
+}
+
+uint32_t
+TcpRequestHeader::GetSerializedSize (void) const
+{
+  return 4 + 4 + 4 + 8 + 8;
+}
+
+void
+TcpRequestHeader::Serialize (Buffer::Iterator start) const
+{
+  Buffer::Iterator i = start;
+  i.WriteHtonU32 (m_sessionId);
+  i.WriteHtonU32 (m_requestId);
+  i.WriteHtonU32 (m_objectId);
+  i.WriteHtonU64 (m_objectSize);
+  i.WriteHtonU64 (m_offset);
+}
+
+uint32_t
+TcpRequestHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_sessionId = i.ReadNtohU32 ();
+  m_requestId = i.ReadNtohU32 ();
+  m_objectId = i.ReadNtohU32 ();
+  m_objectSize = i.ReadNtohU64 ();
+  m_offset = i.ReadNtohU64 ();
+  return GetSerializedSize ();
+}
+
+void
+TcpRequestHeader::SetSessionId (uint32_t sessionId)
+{
+  m_sessionId = sessionId;
+}
+
+uint32_t
+TcpRequestHeader::GetSessionId (void) const
+{
+  return m_sessionId;
+}
+
+void
+TcpRequestHeader::SetRequestId (uint32_t requestId)
+{
+  m_requestId = requestId;
+}
+
+uint32_t
+TcpRequestHeader::GetRequestId (void) const
+{
+  return m_requestId;
+}
+
+void
+TcpRequestHeader::SetObjectId (uint32_t objectId)
+{
+  m_objectId = objectId;
+}
+
+uint32_t
+TcpRequestHeader::GetObjectId (void) const
+{
+  return m_objectId;
+}
+
+void
+TcpRequestHeader::SetObjectSize (uint64_t objectSize)
+{
+  m_objectSize = objectSize;
+}
+
+uint64_t
+TcpRequestHeader::GetObjectSize (void) const
+{
+  return m_objectSize;
+}
+
+void
+TcpRequestHeader::SetOffset (uint64_t offset)
+{
+  m_offset = offset;
+}
+
+uint64_t
+TcpRequestHeader::GetOffset (void) const
+{
+  return m_offset;
+}
+
+} // namespace ns3
@@ -0,0 +1,95 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef TCP_REQUEST_HEADER_H
+#define TCP_REQUEST_HEADER_H
+
+#include "ns3/header.h"
+
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup tcpserver
+ * \brief Transfer request sent by a TcpClientApplication.
+ *
+ * Requests are framed with a fixed size, so a client can pipeline several
+ * of them on one persistent connection; the server answers them in order.
+ * The request id numbers the requests of a session, the object size is
+ * the size of the response (zero for the server's MaxTxBytes).
+ *
+ * The session id names the transfers of a client across its
+ * reconnections; the offset is the number of bytes of the object the
+ * client already holds, so the server only sends the rest.
+ *
+ * The object id names the content, so that a cache can tell two requests
+ * for the same object; zero is an object of its own that is never cached.
+ */
+class TcpRequestHeader : public Header
+{
+public:
+  TcpRequestHeader ();
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+
+  /**
+   * \param sessionId the session id of the transfer
+   */
+  void SetSessionId (uint32_t sessionId);
+  /**
+   * \return the session id of the transfer
+   */
+  uint32_t GetSessionId (void) const;
+  /**
+   * \param requestId the id of the request within its session
+   */
+  void SetRequestId (uint32_t requestId);
+  /**
+   * \return the id of the request within its session
+   */
+  uint32_t GetRequestId (void) const;
+  /**
+   * \param objectId the id of the requested object, 0 for none
+   */
+  void SetObjectId (uint32_t objectId);
+  /**
+   * \return the id of the requested object, 0 for none
+   */
+  uint32_t GetObjectId (void) const;
+  /**
+   * \param objectSize the size of the requested object, 0 for the default
+   */
+  void SetObjectSize (uint64_t objectSize);
+  /**
+   * \return the size of the requested object, 0 for the default
+   */
+  uint64_t GetObjectSize (void) const;
+  /**
+   * \param offset the number of bytes already received
+   */
+  void SetOffset (uint64_t offset);
+  /**
+   * \return the number of bytes already received
+   */
+  uint64_t GetOffset (void) const;
+
+private:
+  uint32_t m_sessionId;   //!< Session id
+  uint32_t m_requestId;   //!< Request id within the session
+  uint32_t m_objectId;    //!< Requested object id
+  uint64_t m_objectSize;  //!< Requested object size
+  uint64_t m_offset;      //!< Bytes already received
+};
+
+} // namespace ns3
+
+#endif /* TCP_REQUEST_HEADER_H */
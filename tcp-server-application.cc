@@ -7,16 +7,22 @@
 #include "ns3/socket.h"
 #include "ns3/udp-socket.h"
 #include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/enum.h"
+#include "ns3/data-rate.h"
 #include "ns3/simulator.h"
 #include "ns3/socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/udp-socket-factory.h"
 #include "tcp-server-application.h"
+#include "tcp-socket-options.h"
 #include "ns3/string.h"
 #include "ns3/inet-socket-address.h"
 #include "ns3/names.h"
 
+#include <algorithm>
+
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("TcpServerApplication");
@@ -39,13 +45,117 @@ TcpServerApplication::GetTypeId (void)
                    UintegerValue (512),
                    MakeUintegerAccessor (&TcpServerApplication::m_sendSize),
                    MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("AdaptiveSendSize",
+                   "If true, ignore SendSize and size each write from the "
+                   "socket's SegmentSize and the free space of its tx "
+                   "buffer, coalescing up to MaxSegmentsPerSend segments. "
+                   "A connection whose tx buffer is smaller than a segment "
+                   "uses SendSize.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpServerApplication::m_adaptiveSendSize),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MaxSegmentsPerSend",
+                   "Largest write in AdaptiveSendSize mode, in segments.",
+                   UintegerValue (64),
+                   MakeUintegerAccessor (&TcpServerApplication::m_maxSegmentsPerSend),
+                   MakeUintegerChecker<uint32_t> (1))
     .AddAttribute ("MaxTxBytes",
-                   "The total number of bytes to send. "
-                   "Once these bytes are sent, "
-                   "no data  is sent again. The value zero means "
+                   "The number of bytes sent for a request that does not "
+                   "give an object size. The value zero means "
                    "that there is no limit.",
                    UintegerValue (0),
                    MakeUintegerAccessor (&TcpServerApplication::m_maxBytes),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("Persistent",
+                   "If true, keep a connection open once a request is served "
+                   "and serve the requests pipelined behind it. "
+                   "Otherwise close it after the first response.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpServerApplication::m_persistent),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MaxActiveConnections",
+                   "The number of connections served at once. Further "
+                   "connections wait in the pending queue until one closes. "
+                   "The value zero means that there is no limit.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&TcpServerApplication::m_maxActive),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MaxPendingConnections",
+                   "The number of accepted connections waiting to be served. "
+                   "Connection requests beyond it are refused. "
+                   "The value zero means that there is no limit.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&TcpServerApplication::m_maxPending),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Scheduler",
+                   "How the connections with data to send share the writes: "
+                   "Greedy fills the socket that has room before looking at "
+                   "the others, RoundRobin gives each flow one write in turn "
+                   "and Drr gives each flow Quantum bytes in turn.",
+                   EnumValue (GREEDY),
+                   MakeEnumAccessor (&TcpServerApplication::m_scheduler),
+                   MakeEnumChecker (GREEDY, "Greedy",
+                                    ROUND_ROBIN, "RoundRobin",
+                                    DRR, "Drr"))
+    .AddAttribute ("Quantum",
+                   "Bytes a flow may write per turn with the Drr scheduler.",
+                   UintegerValue (4096),
+                   MakeUintegerAccessor (&TcpServerApplication::m_quantum),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("CoalesceRequests",
+                   "If true, responses sending the same object (same object "
+                   "id and size) at the same time share its payload, which "
+                   "is then built once whatever the number of requests.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpServerApplication::m_coalesce),
+                   MakeBooleanChecker ())
+    .AddAttribute ("FlowRate",
+                   "Rate each connection is paced to by a token bucket. "
+                   "The value zero means that flows are not paced.",
+                   DataRateValue (DataRate (0)),
+                   MakeDataRateAccessor (&TcpServerApplication::m_flowRate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("MaxRate",
+                   "Rate all connections together are capped to by a token "
+                   "bucket. The value zero means that there is no cap.",
+                   DataRateValue (DataRate (0)),
+                   MakeDataRateAccessor (&TcpServerApplication::m_maxRate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("PacingBurst",
+                   "Depth of the token buckets of FlowRate and MaxRate, in "
+                   "bytes; no write is larger while pacing.",
+                   UintegerValue (16384),
+                   MakeUintegerAccessor (&TcpServerApplication::m_pacingBurst),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("CongestionControl",
+                   "TypeId name of the TCP congestion control of the accepted sockets, "
+                   "e.g. ns3::TcpCubic. Empty for the node's default.",
+                   StringValue (""),
+                   MakeStringAccessor (&TcpServerApplication::m_congestionControl),
+                   MakeStringChecker ())
+    .AddAttribute ("InitialCwnd",
+                   "Initial congestion window of the accepted sockets, in segments. "
+                   "The value zero keeps the TcpSocket default.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&TcpServerApplication::m_initialCwnd),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("SndBufSize",
+                   "Tx buffer size of the accepted sockets, in bytes. "
+                   "The value zero keeps the TcpSocket default.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&TcpServerApplication::m_sndBufSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("RcvBufSize",
+                   "Rx buffer size of the accepted sockets, in bytes. "
+                   "The value zero keeps the TcpSocket default.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&TcpServerApplication::m_rcvBufSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("SegmentSize",
+                   "TCP maximum segment size of the accepted sockets, in bytes. "
+                   "The value zero keeps the TcpSocket default.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&TcpServerApplication::m_segmentSize),
                    MakeUintegerChecker<uint32_t> ())
     .AddTraceSource ("Tx", "A new packet is created and is sent",
                      MakeTraceSourceAccessor (&TcpServerApplication::m_txTrace),
@@ -54,6 +164,20 @@ TcpServerApplication::GetTypeId (void)
                      "A packet has been received",
                      MakeTraceSourceAccessor (&TcpServerApplication::m_rxTrace),
                      "ns3::Packet::PacketAddressTracedCallback")
+    .AddTraceSource ("RxBatch",
+                     "The socket has been drained: bytes, packets, peer",
+                     MakeTraceSourceAccessor (&TcpServerApplication::m_rxBatchTrace),
+                     "ns3::TcpServerApplication::RxBatchTracedCallback")
+    .AddTraceSource ("ResponseComplete",
+                     "A response has been fully written to the socket: "
+                     "request id, bytes, time to first and to last write",
+                     MakeTraceSourceAccessor (&TcpServerApplication::m_responseTrace),
+                     "ns3::TcpTransferStats::TransferTracedCallback")
+    .AddTraceSource ("FlowShare",
+                     "A connection has been closed: peer, bytes sent on it "
+                     "and their fraction of the bytes sent while it was open",
+                     MakeTraceSourceAccessor (&TcpServerApplication::m_shareTrace),
+                     "ns3::TcpServerApplication::FlowShareTracedCallback")
   ;
   return tid;
 }
@@ -63,7 +187,16 @@ TcpServerApplication::TcpServerApplication ()
   NS_LOG_FUNCTION (this);
   m_socket = 0;
   m_totalRx = 0;
-  m_totBytes = 0;
+  m_totalTx = 0;
+  m_sendCalls = 0;
+  m_resumedBytes = 0;
+  m_resumedSessions = 0;
+  m_peakActive = 0;
+  m_rejected = 0;
+  m_serving = false;
+  m_coalescedRequests = 0;
+  m_coalescedBytes = 0;
+  m_pacingWaits = 0;
 }
 
 TcpServerApplication::~TcpServerApplication()
@@ -71,19 +204,116 @@ TcpServerApplication::~TcpServerApplication()
   NS_LOG_FUNCTION (this);
 }
 
-uint32_t TcpServerApplication::GetTotalRx () const
+uint64_t TcpServerApplication::GetTotalRx () const
 {
   NS_LOG_FUNCTION (this);
   return m_totalRx;
 }
 
+uint64_t TcpServerApplication::GetTotalTx () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_totalTx;
+}
+
+const TcpTransferStats &
+TcpServerApplication::GetStats () const
+{
+  return m_stats;
+}
+
 void
-TcpServerApplication::SetMaxBytes (uint32_t maxBytes)
+TcpServerApplication::SetMaxBytes (uint64_t maxBytes)
 {
   NS_LOG_FUNCTION (this << maxBytes);
   m_maxBytes = maxBytes;
 }
 
+uint64_t
+TcpServerApplication::GetResumedBytes () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_resumedBytes;
+}
+
+uint32_t
+TcpServerApplication::GetResumedSessions () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_resumedSessions;
+}
+
+uint64_t
+TcpServerApplication::GetSendCalls () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_sendCalls;
+}
+
+uint32_t
+TcpServerApplication::GetActiveConnections () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_flows.GetN ();
+}
+
+uint32_t
+TcpServerApplication::GetPendingConnections () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_pendingSockets.size ();
+}
+
+uint32_t
+TcpServerApplication::GetPeakActiveConnections () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_peakActive;
+}
+
+uint64_t
+TcpServerApplication::GetRejectedConnections () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_rejected;
+}
+
+uint64_t
+TcpServerApplication::GetCoalescedRequests () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_coalescedRequests;
+}
+
+uint64_t
+TcpServerApplication::GetCoalescedBytes () const
+{
+  NS_LOG_FUNCTION (this);
+  // Objects still being sent count what they have saved so far
+  uint64_t bytes = m_coalescedBytes;
+  for (std::map<ObjectKey, Ptr<TcpSharedPayload> >::const_iterator it = m_shared.begin ();
+       it != m_shared.end (); ++it)
+    {
+      bytes += it->second->GetServedBytes ()
+        - std::min (it->second->GetServedBytes (), it->second->GetBuiltBytes ());
+    }
+  return bytes;
+}
+
+uint64_t
+TcpServerApplication::GetPacingWaits () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_pacingWaits;
+}
+
+Time
+TcpServerApplication::GetPacingDelay () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_pacingDelay;
+}
+
 Ptr<Socket>
 TcpServerApplication::GetListeningSocket (void) const
 {
@@ -95,14 +325,25 @@ std::list<Ptr<Socket> >
 TcpServerApplication::GetAcceptedSockets (void) const
 {
   NS_LOG_FUNCTION (this);
-  return m_socketList;
+  std::list<Ptr<Socket> > sockets = m_flows.GetSockets ();
+  for (std::deque<std::pair<Ptr<Socket>, Address> >::const_iterator it = m_pendingSockets.begin ();
+       it != m_pendingSockets.end (); ++it)
+    {
+      sockets.push_back (it->first);
+    }
+  return sockets;
 }
 
 void TcpServerApplication::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
   m_socket = 0;
-  m_socketList.clear ();
+  m_admitEvent.Cancel ();
+  m_pendingSockets.clear ();
+  m_rotation.clear ();
+  m_flows.Clear ();
+  m_shared.clear ();
+  m_payload = 0;
   Application::DoDispose ();
 }
 
@@ -116,14 +357,22 @@ void TcpServerApplication::StartApplication ()    // Called at time specified by
   if (!m_socket)
     {
       m_socket = Socket::CreateSocket (GetNode (), m_tid);
+      // The accepted sockets are forks of this one
+      ConfigureTcpSocket (m_socket, m_congestionControl, m_initialCwnd,
+                          m_sndBufSize, m_rcvBufSize, m_segmentSize);
       m_socket->Bind (m_local);
       m_socket->Listen ();
       //m_socket->ShutdownSend ();
     }
+  if (!m_payload)
+    {
+      m_payload = Create<TcpPayloadSource> (m_sendSize);
+    }
+  m_rateCap.Configure (m_maxRate, m_pacingBurst);
 
   m_socket->SetRecvCallback (MakeCallback (&TcpServerApplication::HandleRead, this));
   m_socket->SetAcceptCallback (
-    MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+    MakeCallback (&TcpServerApplication::HandleConnectionRequest, this),
     MakeCallback (&TcpServerApplication::HandleAccept, this));
   m_socket->SetCloseCallbacks (
     MakeCallback (&TcpServerApplication::HandlePeerClose, this),
@@ -133,12 +382,17 @@ void TcpServerApplication::StartApplication ()    // Called at time specified by
 void TcpServerApplication::StopApplication ()     // Called at time specified by Stop
 {
   NS_LOG_FUNCTION (this);
-  while(!m_socketList.empty ()) //these are accepted sockets, close them
+  std::list<Ptr<Socket> > accepted = GetAcceptedSockets ();
+  m_admitEvent.Cancel ();
+  m_pendingSockets.clear ();
+  m_rotation.clear ();
+  m_flows.Clear ();
+  m_shared.clear ();
+  while(!accepted.empty ()) //these are accepted sockets, close them
     {
-      Ptr<Socket> acceptedSocket = m_socketList.front ();
-      m_socketList.pop_front ();
+      Ptr<Socket> acceptedSocket = accepted.front ();
+      accepted.pop_front ();
       acceptedSocket->Close ();
-      sv_connected.clear();
     }
   if (m_socket) 
     {
@@ -147,46 +401,298 @@ void TcpServerApplication::StopApplication ()     // Called at time specified by
     }
 }
 
-void TcpServerApplication::SendData (Ptr<Socket> sock, Address from)
-{
-  NS_LOG_FUNCTION (this << sock);
-
-  if(sv_connected.find(from) == sv_connected.end())
-  {
-    // do nothing
-  }
-  else if(sv_connected[from])
-  {
-    while (m_maxBytes == 0 || m_totBytes < m_maxBytes)
-      { // Time to send more
-        uint32_t toSend = m_sendSize;
-        // Make sure we don't send too many
-        if (m_maxBytes > 0)
-          {
-            toSend = std::min (m_sendSize, m_maxBytes - m_totBytes);
-          }
-        NS_LOG_LOGIC ("sending packet at " << Simulator::Now ());
-        Ptr<Packet> packet = Create<Packet> (toSend);
-        m_txTrace (packet);
-        int actual = sock->SendTo (packet, 0, from);
-        if (actual > 0)
-          {
-            m_totBytes += actual;
-          }
-        // We exit this loop when actual < toSend as the send side
-        // buffer is full. The "DataSent" callback will pop when
-        // some buffer space has freed ip.
-        if ((unsigned)actual != toSend)
-          {
-            break;
-          }
-      }
-      // Check if time to close (all sent)
-      if (m_totBytes == m_maxBytes && sv_connected[from])
+void TcpServerApplication::SendData (TcpServerFlow *flow)
+{
+  NS_LOG_FUNCTION (this << flow->socket);
+
+  while (flow->state == TcpServerFlow::SENDING)
+    {
+      if (flow->endless || flow->bytesRemaining > 0)
+        { // Time to send more
+          uint32_t toSend = GetNextSendSize (flow);
+          if (toSend == 0)
+            {
+              // The send side buffer is full. DataSend will resume this
+              // flow when some buffer space has freed up.
+              break;
+            }
+          toSend = Pace (flow, toSend);
+          if (toSend == 0)
+            { // PaceWake resumes this flow once the tokens are there
+              break;
+            }
+          if (WriteChunk (flow, toSend) != toSend)
+            {
+              break;
+            }
+          continue;
+        }
+
+      // The current request is complete
+      if (!FinishRequest (flow))
+        {
+          return;
+        }
+    }
+}
+
+uint32_t TcpServerApplication::WriteChunk (TcpServerFlow *flow, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << flow->socket << size);
+  NS_LOG_LOGIC ("sending packet at " << Simulator::Now ());
+  Ptr<Packet> packet = flow->shared ? flow->shared->Get (flow->objectOffset, size)
+    : m_payload->Get (size);
+  m_txTrace (packet);
+  int actual = flow->socket->SendTo (packet, 0, flow->peer);
+  ++m_sendCalls;
+  if (actual <= 0)
+    {
+      return 0;
+    }
+  if (flow->bytesSent == 0)
+    {
+      flow->firstByteTime = Simulator::Now ();
+    }
+  flow->bytesSent += actual;
+  flow->connectionBytes += actual;
+  flow->objectOffset += actual;
+  flow->pacer.Consume (actual);
+  m_rateCap.Consume (actual);
+  m_totalTx += actual;
+  if (!flow->endless)
+    {
+      flow->bytesRemaining -= actual;
+    }
+  return actual;
+}
+
+bool TcpServerApplication::FinishRequest (TcpServerFlow *flow)
+{
+  NS_LOG_FUNCTION (this << flow->socket);
+  NS_LOG_INFO ("Request " << flow->requestId << " of session " << flow->sessionId
+               << " to " << flow->peer << " sent " << flow->bytesSent
+               << " bytes in "
+               << (Simulator::Now () - flow->startTime).GetSeconds () << "s");
+  Time firstByte = flow->bytesSent > 0 ? flow->firstByteTime - flow->startTime : Time ();
+  Time completion = Simulator::Now () - flow->startTime;
+  m_stats.Add (flow->bytesSent, firstByte, completion);
+  m_responseTrace (flow->requestId, flow->bytesSent, firstByte, completion);
+  ReleaseSharedPayload (flow);
+  if (!m_persistent)
+    { // the flow keeps its slot until the close completes
+      flow->state = TcpServerFlow::DONE;
+      flow->socket->Close ();
+      return false;
+    }
+  flow->state = TcpServerFlow::IDLE;
+  StartNextRequest (flow);
+  return true;
+}
+
+void TcpServerApplication::Schedule (TcpServerFlow *flow)
+{
+  NS_LOG_FUNCTION (this << flow->socket);
+  if (!flow->scheduled)
+    {
+      flow->scheduled = true;
+      m_rotation.push_back (flow->socket);
+    }
+  Serve ();
+}
+
+void TcpServerApplication::Serve (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_serving)
+    { // a flow scheduled from within a turn waits for its own turn
+      return;
+    }
+  m_serving = true;
+  while (!m_rotation.empty ())
+    {
+      Ptr<Socket> socket = m_rotation.front ();
+      m_rotation.pop_front ();
+      if (ServeFlow (socket))
+        {
+          m_rotation.push_back (socket);
+          continue;
+        }
+      // Out of data or of buffer space; HandleRequests or DataSend puts
+      // the flow back in the rotation. The flow may be gone if its
+      // connection was closed during its turn.
+      TcpServerFlow *flow = m_flows.Find (socket);
+      if (flow)
+        {
+          flow->scheduled = false;
+        }
+    }
+  m_serving = false;
+}
+
+bool TcpServerApplication::ServeFlow (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  TcpServerFlow *flow = m_flows.Find (socket);
+  if (!flow)
+    {
+      return false;
+    }
+  if (m_scheduler == DRR)
+    {
+      flow->deficit += m_quantum;
+    }
+  uint32_t writes = 0;
+  while (flow->state == TcpServerFlow::SENDING)
+    {
+      if (!flow->endless && flow->bytesRemaining == 0)
+        {
+          if (!FinishRequest (flow))
+            {
+              return false;
+            }
+          continue;
+        }
+      if (m_scheduler == ROUND_ROBIN && writes > 0)
+        {
+          return true;
+        }
+      uint32_t toSend = GetNextSendSize (flow);
+      if (toSend == 0)
+        {
+          // Do not bank quanta while the socket is full
+          flow->deficit = std::min<uint64_t> (flow->deficit, m_quantum);
+          return false;
+        }
+      if (m_scheduler == DRR)
+        {
+          if (flow->deficit == 0)
+            {
+              return true;
+            }
+          toSend = static_cast<uint32_t> (std::min<uint64_t> (toSend, flow->deficit));
+        }
+      toSend = Pace (flow, toSend);
+      if (toSend == 0)
+        { // PaceWake puts the flow back in the rotation
+          flow->deficit = std::min<uint64_t> (flow->deficit, m_quantum);
+          return false;
+        }
+      uint32_t actual = WriteChunk (flow, toSend);
+      ++writes;
+      if (m_scheduler == DRR)
+        {
+          flow->deficit -= actual;
+        }
+      if (actual != toSend)
+        {
+          return false;
+        }
+    }
+  // An idle flow starts over when its next request arrives
+  flow->deficit = 0;
+  return false;
+}
+
+uint32_t TcpServerApplication::GetNextSendSize (TcpServerFlow *flow) const
+{
+  uint32_t available = flow->socket->GetTxAvailable ();
+  uint32_t toSend;
+  if (m_adaptiveSendSize && flow->segmentSize > 0)
+    {
+      // Whole segments only, so that a write never leaves a runt segment
+      // behind in the tx buffer; the tail of a transfer is the exception.
+      uint32_t segments = std::min (available / flow->segmentSize, m_maxSegmentsPerSend);
+      toSend = segments * flow->segmentSize;
+      if (!flow->endless && flow->bytesRemaining <= available)
+        {
+          toSend = std::max (toSend, static_cast<uint32_t> (
+                               std::min<uint64_t> (flow->bytesRemaining,
+                                                   m_maxSegmentsPerSend * flow->segmentSize)));
+        }
+    }
+  else
+    {
+      // Never write more than the tx buffer can take, so that a write
+      // is either fully accepted or not attempted at all.
+      toSend = std::min (m_sendSize, available);
+    }
+  // Make sure we don't send too many
+  if (!flow->endless)
+    {
+      toSend = static_cast<uint32_t> (std::min<uint64_t> (toSend, flow->bytesRemaining));
+    }
+  if (flow->shared)
+    { // a write is a fragment of a single chunk of the shared payload
+      toSend = std::min (toSend, flow->shared->GetContiguous (flow->objectOffset));
+    }
+  return toSend;
+}
+
+uint32_t TcpServerApplication::Pace (TcpServerFlow *flow, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << flow->socket << size);
+  if (!flow->pacer.IsEnabled () && !m_rateCap.IsEnabled ())
+    {
+      return size;
+    }
+  // No write is larger than a burst, so that the tokens for any write
+  // eventually accrue
+  size = std::min (size, m_pacingBurst);
+  Time wait;
+  if (flow->pacer.IsEnabled ())
+    {
+      wait = flow->pacer.GetWaitTime (size);
+    }
+  if (m_rateCap.IsEnabled ())
+    {
+      wait = Max (wait, m_rateCap.GetWaitTime (size));
+    }
+  if (wait.IsZero ())
+    {
+      return size;
+    }
+  if (!flow->paceEvent.IsRunning ())
+    {
+      NS_LOG_LOGIC ("flow to " << flow->peer << " waits " << wait << " for "
+                    << size << " bytes of tokens");
+      flow->paceEvent = Simulator::Schedule (wait, &TcpServerApplication::PaceWake,
+                                             this, flow->socket);
+      ++m_pacingWaits;
+      m_pacingDelay += wait;
+    }
+  return 0;
+}
+
+void TcpServerApplication::PaceWake (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  TcpServerFlow *flow = m_flows.Find (socket);
+  if (flow && flow->state == TcpServerFlow::SENDING)
+    {
+      if (m_scheduler == GREEDY)
         {
-          sv_connected[from] = false;
-          m_totBytes = 0;
-          sock->Close ();
+          SendData (flow);
+        }
+      else
+        {
+          Schedule (flow);
+        }
+    }
+}
+
+void TcpServerApplication::DataSend (Ptr<Socket> socket, uint32_t available)
+{
+  NS_LOG_FUNCTION (this << socket << available);
+  TcpServerFlow *flow = m_flows.Find (socket);
+  if (flow && flow->state == TcpServerFlow::SENDING)
+    {
+      if (m_scheduler == GREEDY)
+        {
+          SendData (flow);
+        }
+      else
+        {
+          Schedule (flow);
         }
     }
 }
@@ -194,51 +700,268 @@ void TcpServerApplication::SendData (Ptr<Socket> sock, Address from)
 void TcpServerApplication::HandleRead (Ptr<Socket> socket)
 {
   NS_LOG_FUNCTION (this << socket);
-  Ptr<Packet> packet, pktSend;
+  Ptr<Packet> packet;
   Address from;
+  uint32_t bytes = 0;
+  uint32_t packets = 0;
+  TcpServerFlow *flow = m_flows.Find (socket);
+  // Drain the socket first and account for the whole batch at once;
+  // per-packet tracing is only paid for when someone listens.
   while ((packet = socket->RecvFrom (from)))
     {
-      if (packet->GetSize () == 0)
+      uint32_t size = packet->GetSize ();
+      if (size == 0)
         { //EOF
           break;
         }
-      m_totalRx += packet->GetSize ();
-      if (InetSocketAddress::IsMatchingType (from))
+      bytes += size;
+      ++packets;
+      if (!m_rxTrace.IsEmpty ())
         {
-          NS_LOG_INFO ("At time " << Simulator::Now ().GetSeconds ()
-                       << "s packet sink received "
-                       <<  packet->GetSize () << " bytes from "
-                       << InetSocketAddress::ConvertFrom(from).GetIpv4 ()
-                       << " port " << InetSocketAddress::ConvertFrom (from).GetPort ()
-                       << " total Rx " << m_totalRx << " bytes");
+          m_rxTrace (packet, from);
         }
-      m_rxTrace (packet, from);
-      if (packet->GetSize () == 13)
-        { //EOF
-          SendData(socket, from);
+      if (flow)
+        { // keep the request bytes until a whole header is there
+          if (!flow->rxBuffer)
+            {
+              flow->rxBuffer = packet;
+            }
+          else
+            {
+              flow->rxBuffer->AddAtEnd (packet);
+            }
         }
     }
+  if (packets == 0)
+    {
+      return;
+    }
+  m_totalRx += bytes;
+  if (InetSocketAddress::IsMatchingType (from))
+    {
+      NS_LOG_INFO ("At time " << Simulator::Now ().GetSeconds ()
+                   << "s packet sink received "
+                   << bytes << " bytes in " << packets << " packets from "
+                   << InetSocketAddress::ConvertFrom(from).GetIpv4 ()
+                   << " port " << InetSocketAddress::ConvertFrom (from).GetPort ()
+                   << " total Rx " << m_totalRx << " bytes");
+    }
+  m_rxBatchTrace (bytes, packets, from);
+  if (flow)
+    {
+      HandleRequests (flow);
+    }
+}
+
+void TcpServerApplication::HandleRequests (TcpServerFlow *flow)
+{
+  NS_LOG_FUNCTION (this << flow->socket);
+  TcpRequestHeader request;
+  while (flow->rxBuffer && flow->rxBuffer->GetSize () >= request.GetSerializedSize ())
+    {
+      flow->rxBuffer->RemoveHeader (request);
+      NS_LOG_LOGIC ("request " << request << " from " << flow->peer);
+      flow->pending.push_back (request);
+    }
+  if (flow->state == TcpServerFlow::IDLE && StartNextRequest (flow))
+    {
+      if (m_scheduler == GREEDY)
+        {
+          SendData (flow);
+        }
+      else
+        {
+          Schedule (flow);
+        }
+    }
+}
+
+bool TcpServerApplication::StartNextRequest (TcpServerFlow *flow)
+{
+  NS_LOG_FUNCTION (this << flow->socket);
+  if (flow->pending.empty ())
+    {
+      return false;
+    }
+  TcpRequestHeader request = flow->pending.front ();
+  flow->pending.pop_front ();
+
+  uint64_t size = request.GetObjectSize () > 0 ? request.GetObjectSize () : m_maxBytes;
+  flow->state = TcpServerFlow::SENDING;
+  flow->sessionId = request.GetSessionId ();
+  flow->requestId = request.GetRequestId ();
+  flow->bytesSent = 0;
+  flow->bytesRemaining = size;
+  flow->endless = (size == 0);
+  flow->startTime = Simulator::Now ();
+  if (!flow->endless && request.GetOffset () > 0)
+    { // the client resumes a transfer, skip what it already has
+      uint64_t skip = std::min (request.GetOffset (), size);
+      flow->bytesRemaining -= skip;
+      m_resumedBytes += skip;
+      ++m_resumedSessions;
+      NS_LOG_INFO ("Session " << flow->sessionId << " resumed at offset "
+                   << skip << ", " << flow->bytesRemaining << " bytes left");
+    }
+  flow->objectId = request.GetObjectId ();
+  flow->objectSize = size;
+  flow->objectOffset = size - flow->bytesRemaining;
+  if (m_coalesce && flow->objectId != 0 && !flow->endless)
+    {
+      Ptr<TcpSharedPayload> &shared = m_shared[ObjectKey (flow->objectId, size)];
+      if (!shared)
+        {
+          shared = Create<TcpSharedPayload> (m_payload, size);
+        }
+      else
+        {
+          NS_LOG_INFO ("Request " << flow->requestId << " joins the "
+                       "response in progress for object " << flow->objectId);
+          ++m_coalescedRequests;
+        }
+      shared->AddReader ();
+      flow->shared = shared;
+    }
+  return true;
+}
+
+void TcpServerApplication::ReleaseSharedPayload (TcpServerFlow *flow)
+{
+  NS_LOG_FUNCTION (this << flow->socket);
+  if (!flow->shared)
+    {
+      return;
+    }
+  if (flow->shared->RemoveReader () == 0)
+    {
+      // The payload goes with its last reader
+      uint64_t served = flow->shared->GetServedBytes ();
+      m_coalescedBytes += served - std::min (served, flow->shared->GetBuiltBytes ());
+      m_shared.erase (ObjectKey (flow->objectId, flow->objectSize));
+    }
+  flow->shared = 0;
 }
 
 
 void TcpServerApplication::HandlePeerClose (Ptr<Socket> socket)
 {
   NS_LOG_FUNCTION (this << socket);
+  TcpServerFlow *flow = m_flows.Find (socket);
+  bool closing = flow && flow->state == TcpServerFlow::DONE;
+  if (ReleaseConnection (socket) && !closing)
+    { // complete the close the peer started
+      socket->Close ();
+    }
 }
  
 void TcpServerApplication::HandlePeerError (Ptr<Socket> socket)
 {
   NS_LOG_FUNCTION (this << socket);
+  ReleaseConnection (socket);
+}
+
+bool TcpServerApplication::ReleaseConnection (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  TcpServerFlow *flow = m_flows.Find (socket);
+  if (flow)
+    {
+      uint64_t sent = m_totalTx - flow->serverTxAtStart;
+      double share = sent > 0 ? static_cast<double> (flow->connectionBytes) / sent : 0;
+      NS_LOG_INFO ("Connection from " << flow->peer << " closed, "
+                   << flow->connectionBytes << " bytes, share " << share);
+      m_shareTrace (flow->peer, flow->connectionBytes, share);
+      ReleaseSharedPayload (flow);
+      m_flows.Remove (socket);
+      if (!m_pendingSockets.empty () && !m_admitEvent.IsRunning ())
+        { // not from within the callbacks of the socket being released
+          m_admitEvent = Simulator::ScheduleNow (&TcpServerApplication::AdmitPending, this);
+        }
+      return true;
+    }
+  // A pending connection closed before it was served; rare enough for a
+  // linear search
+  for (std::deque<std::pair<Ptr<Socket>, Address> >::iterator it = m_pendingSockets.begin ();
+       it != m_pendingSockets.end (); ++it)
+    {
+      if (it->first == socket)
+        {
+          m_pendingSockets.erase (it);
+          return true;
+        }
+    }
+  return false;
+}
+
+bool TcpServerApplication::HandleConnectionRequest (Ptr<Socket> socket, const Address& from)
+{
+  NS_LOG_FUNCTION (this << socket << from);
+  bool full = m_maxActive > 0 && m_flows.GetN () >= m_maxActive
+    && m_maxPending > 0 && m_pendingSockets.size () >= m_maxPending;
+  if (full)
+    {
+      NS_LOG_INFO ("Refusing a connection from " << from << ", "
+                   << m_pendingSockets.size () << " connections pending");
+      ++m_rejected;
+    }
+  return !full;
 }
- 
 
 void TcpServerApplication::HandleAccept (Ptr<Socket> s, const Address& from)
+{
+  NS_LOG_FUNCTION (this << s << from);
+  s->SetCloseCallbacks (
+    MakeCallback (&TcpServerApplication::HandlePeerClose, this),
+    MakeCallback (&TcpServerApplication::HandlePeerError, this));
+  if (m_maxActive > 0 && m_flows.GetN () >= m_maxActive)
+    {
+      // Leave its requests in the socket until it is served
+      s->SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
+      m_pendingSockets.push_back (std::make_pair (s, from));
+      NS_LOG_INFO ("Connection from " << from << " pending, "
+                   << m_pendingSockets.size () << " waiting");
+      return;
+    }
+  Admit (s, from);
+}
+
+void TcpServerApplication::Admit (Ptr<Socket> s, const Address& from)
 {
   NS_LOG_FUNCTION (this << s << from);
   s->SetRecvCallback (MakeCallback (&TcpServerApplication::HandleRead, this));
-  //s->SetSendCallback (MakeCallback (&TcpServerApplication::DataSend, this));
-  m_socketList.push_back (s);
-  sv_connected[from] = true;
+  s->SetSendCallback (MakeCallback (&TcpServerApplication::DataSend, this));
+  TcpServerFlow *flow = m_flows.Add (s, from);
+  flow->serverTxAtStart = m_totalTx;
+  flow->pacer.Configure (m_flowRate, m_pacingBurst);
+  m_peakActive = std::max (m_peakActive, m_flows.GetN ());
+  if (m_adaptiveSendSize)
+    {
+      UintegerValue segmentSize;
+      s->GetAttribute ("SegmentSize", segmentSize);
+      UintegerValue sndBufSize;
+      s->GetAttribute ("SndBufSize", sndBufSize);
+      flow->segmentSize = segmentSize.Get ();
+      if (sndBufSize.Get () < flow->segmentSize)
+        { // whole segments would never fit, and the flow would stall
+          NS_LOG_WARN ("Tx buffer of " << sndBufSize.Get () << " bytes is smaller than a "
+                       << flow->segmentSize << " byte segment; writing SendSize chunks");
+          flow->segmentSize = 0;
+        }
+    }
+}
+
+void TcpServerApplication::AdmitPending (void)
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_pendingSockets.empty ()
+         && (m_maxActive == 0 || m_flows.GetN () < m_maxActive))
+    {
+      std::pair<Ptr<Socket>, Address> pending = m_pendingSockets.front ();
+      m_pendingSockets.pop_front ();
+      Admit (pending.first, pending.second);
+      // Serve what the client sent while it waited
+      HandleRead (pending.first);
+    }
 }
 
 TcpServerApplicationHelper::TcpServerApplicationHelper (Address address)
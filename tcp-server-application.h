@@ -26,11 +26,19 @@
 #include "ns3/ptr.h"
 #include "ns3/traced-callback.h"
 #include "ns3/address.h"
+#include "ns3/data-rate.h"
+#include <deque>
+#include <list>
 #include <map>
+#include <string>
 #include "ns3/object-factory.h"
 #include "ns3/ipv4-address.h"
 #include "ns3/node-container.h"
 #include "ns3/application-container.h"
+#include "tcp-flow-table.h"
+#include "tcp-payload-source.h"
+#include "tcp-request-header.h"
+#include "tcp-transfer-stats.h"
 
 namespace ns3 {
 
@@ -46,6 +54,36 @@ public:
    * \return the object TypeId
    */
   static TypeId GetTypeId (void);
+
+  /**
+   * TracedCallback signature for a drained batch of received data.
+   *
+   * \param [in] bytes the number of bytes drained
+   * \param [in] packets the number of packets drained
+   * \param [in] peer the address the data came from
+   */
+  typedef void (* RxBatchTracedCallback)
+    (uint32_t bytes, uint32_t packets, const Address &peer);
+
+  /**
+   * TracedCallback signature for the share of a closed connection.
+   *
+   * \param [in] peer the address of the client
+   * \param [in] bytes the bytes sent on the connection
+   * \param [in] share the fraction of the bytes the server sent while the
+   *             connection was open that went to this connection
+   */
+  typedef void (* FlowShareTracedCallback)
+    (const Address &peer, uint64_t bytes, double share);
+
+  /// How the accepted connections share the transmit path
+  enum Scheduler
+  {
+    GREEDY,      //!< Fill the socket that has room, in callback order
+    ROUND_ROBIN, //!< One write per flow in turn
+    DRR          //!< Deficit round-robin, Quantum bytes per flow in turn
+  };
+
   TcpServerApplication ();
 
   virtual ~TcpServerApplication ();
@@ -53,9 +91,77 @@ public:
   /**
    * \return the total bytes received in this sink app
    */
-  uint32_t GetTotalRx () const;
+  uint64_t GetTotalRx () const;
+
+  /**
+   * \return the total bytes sent by this app
+   */
+  uint64_t GetTotalTx () const;
+
+  void SetMaxBytes (uint64_t maxBytes);
+
+  /**
+   * \return the statistics of the responses sent
+   */
+  const TcpTransferStats &GetStats () const;
+
+  /**
+   * \return the bytes not sent because resuming clients already held them
+   */
+  uint64_t GetResumedBytes () const;
+
+  /**
+   * \return the number of requests that resumed a transfer
+   */
+  uint32_t GetResumedSessions () const;
+
+  /**
+   * \return the number of writes made to the accepted sockets
+   */
+  uint64_t GetSendCalls () const;
+
+  /**
+   * \return the number of connections being served
+   */
+  uint32_t GetActiveConnections () const;
+
+  /**
+   * \return the number of accepted connections waiting to be served
+   */
+  uint32_t GetPendingConnections () const;
+
+  /**
+   * \return the largest number of connections served at once
+   */
+  uint32_t GetPeakActiveConnections () const;
+
+  /**
+   * \return the number of connection requests refused because the
+   * pending queue was full
+   */
+  uint64_t GetRejectedConnections () const;
+
+  /**
+   * \return the number of requests that joined an identical response
+   * already in progress (CoalesceRequests mode)
+   */
+  uint64_t GetCoalescedRequests () const;
+
+  /**
+   * \return the payload bytes sent without being built for the response,
+   * because an identical response had built them (CoalesceRequests mode)
+   */
+  uint64_t GetCoalescedBytes () const;
+
+  /**
+   * \return the number of times a flow waited for pacing tokens
+   */
+  uint64_t GetPacingWaits () const;
 
-  void SetMaxBytes (uint32_t maxBytes);
+  /**
+   * \return the total time flows waited for pacing tokens
+   */
+  Time GetPacingDelay () const;
 
   /**
    * \return pointer to listening socket
@@ -63,7 +169,7 @@ public:
   Ptr<Socket> GetListeningSocket (void) const;
 
   /**
-   * \return list of pointers to accepted sockets
+   * \return list of pointers to accepted sockets, served or pending
    */
   std::list<Ptr<Socket> > GetAcceptedSockets (void) const;
  
@@ -80,13 +186,117 @@ private:
    */
   void HandleRead (Ptr<Socket> socket);
 
-  void SendData (Ptr<Socket> socket, Address from); // for socket's SetSendCallback
+  /**
+   * \brief Send data on a flow until its budget is spent or the L4
+   * transmission buffer is full (GREEDY scheduler).
+   * \param flow the flow to serve
+   */
+  void SendData (TcpServerFlow *flow);
+  /**
+   * \brief Write one chunk of the current request of a flow.
+   * \param flow the flow
+   * \param size the size of the chunk
+   * \return the bytes accepted by the socket
+   */
+  uint32_t WriteChunk (TcpServerFlow *flow, uint32_t size);
+  /**
+   * \brief Account for the completed request of a flow, then start the
+   * next one or close the connection.
+   * \param flow the flow
+   * \return false if the connection was closed, and flow is gone
+   */
+  bool FinishRequest (TcpServerFlow *flow);
+  /**
+   * \brief Put a flow with data to send in the scheduler's rotation and
+   * serve the rotation (ROUND_ROBIN and DRR schedulers).
+   * \param flow the flow
+   */
+  void Schedule (TcpServerFlow *flow);
+  /**
+   * \brief Give the flows of the rotation their turn until none can write.
+   */
+  void Serve (void);
+  /**
+   * \brief Give one flow its turn.
+   * \param socket the socket of the flow
+   * \return true if the flow has data to send and room to send it
+   */
+  bool ServeFlow (Ptr<Socket> socket);
+  /**
+   * \brief Parse the requests received on a flow and queue them.
+   * \param flow the flow
+   */
+  void HandleRequests (TcpServerFlow *flow);
+  /**
+   * \brief Start serving the next queued request of a flow.
+   * \param flow the flow, which must not be serving a request
+   * \return false if no request was queued
+   */
+  bool StartNextRequest (TcpServerFlow *flow);
+  /**
+   * \brief Limit a write of a flow to its pacer and the server's rate cap.
+   *
+   * If the tokens for the write are not there yet, a wake-up is set for
+   * when they will be.
+   *
+   * \param flow the flow
+   * \param size the size of the write
+   * \return the size to write now, 0 to wait for tokens
+   */
+  uint32_t Pace (TcpServerFlow *flow, uint32_t size);
+  /**
+   * \brief Resume a flow that waited for pacing tokens.
+   * \param socket the socket of the flow
+   */
+  void PaceWake (Ptr<Socket> socket);
+  /**
+   * \brief Stop sharing the payload of the current object of a flow.
+   * \param flow the flow
+   */
+  void ReleaseSharedPayload (TcpServerFlow *flow);
+  /**
+   * \brief Pick the size of the next write of a flow.
+   * \param flow the flow to serve
+   * \return the number of bytes to write, 0 to wait for tx buffer space
+   */
+  uint32_t GetNextSendSize (TcpServerFlow *flow) const;
+  /**
+   * \brief Resume the flow of a socket once its tx buffer has drained
+   * (called by Socket through a callback)
+   * \param socket the accepted socket
+   * \param available the number of bytes available in the tx buffer
+   */
+  void DataSend (Ptr<Socket> socket, uint32_t available);
+  /**
+   * \brief Decide whether to accept a connection request
+   * \param socket the listening socket
+   * \param from the address the request is from
+   * \return false if the pending queue is full
+   */
+  bool HandleConnectionRequest (Ptr<Socket> socket, const Address& from);
   /**
    * \brief Handle an incoming connection
    * \param socket the incoming connection socket
    * \param from the address the connection is from
    */
   void HandleAccept (Ptr<Socket> socket, const Address& from);
+  /**
+   * \brief Start serving an accepted connection.
+   * \param socket the accepted socket
+   * \param from the address of the client
+   */
+  void Admit (Ptr<Socket> socket, const Address& from);
+  /**
+   * \brief Serve pending connections while there is room.
+   */
+  void AdmitPending (void);
+  /**
+   * \brief Forget a connection that is closed or being closed, and
+   * schedule a pending one to be served in its place.
+   * \param socket the accepted socket
+   * \return false if the connection was already forgotten
+   */
+  bool ReleaseConnection (Ptr<Socket> socket);
   /**
    * \brief Handle an connection close
    * \param socket the connected socket
@@ -101,18 +311,60 @@ private:
   // In the case of TCP, each socket accept returns a new socket, so the 
   // listening socket is stored separately from the accepted sockets
   Ptr<Socket>     m_socket;       //!< Listening socket
-  std::list<Ptr<Socket> > m_socketList; //!< the accepted sockets
-  std::map<Address,bool> sv_connected; // list of connected clients
+  TcpFlowTable    m_flows;        //!< Transfer state of each served socket
+  /// Accepted sockets waiting for a free slot, oldest first
+  std::deque<std::pair<Ptr<Socket>, Address> > m_pendingSockets;
+  EventId         m_admitEvent;   //!< Admission of pending connections
+  uint32_t        m_maxActive;    //!< Connections served at once, 0 for no limit
+  uint32_t        m_maxPending;   //!< Connections waiting at once, 0 for no limit
+  uint32_t        m_peakActive;   //!< Largest number of connections served at once
+  uint64_t        m_rejected;     //!< Connection requests refused
+  Scheduler       m_scheduler;    //!< How flows share the transmit path
+  uint32_t        m_quantum;      //!< DRR bytes per flow and round
+  std::deque<Ptr<Socket> > m_rotation; //!< Flows waiting for their turn
+  bool            m_serving;      //!< True while Serve runs
+  Ptr<TcpPayloadSource> m_payload; //!< Source of the payload packets
+  /// Object of a request: id and size
+  typedef std::pair<uint32_t, uint64_t> ObjectKey;
+  bool            m_coalesce;     //!< Share the payload of identical responses
+  std::map<ObjectKey, Ptr<TcpSharedPayload> > m_shared; //!< Objects being sent
+  uint64_t        m_coalescedRequests; //!< Requests that joined a response
+  uint64_t        m_coalescedBytes; //!< Bytes sent from payload built by others
+  DataRate        m_flowRate;     //!< Pacing rate of each flow, 0 for none
+  DataRate        m_maxRate;      //!< Rate cap of all flows, 0 for none
+  uint32_t        m_pacingBurst;  //!< Depth of the token buckets
+  TcpTokenBucket  m_rateCap;      //!< Token bucket of all flows
+  uint64_t        m_pacingWaits;  //!< Times a flow waited for tokens
+  Time            m_pacingDelay;  //!< Time flows waited for tokens
   Address         m_local;        //!< Local address to bind to
-  uint32_t        m_totalRx;      //!< Total bytes received
+  uint64_t        m_totalRx;      //!< Total bytes received
+  uint64_t        m_totalTx;      //!< Total bytes sent
   uint32_t        m_sendSize;     //!< Size of data to send each time
-  uint32_t        m_maxBytes;     //!< Limit total number of bytes sent
-  uint32_t        m_totBytes;     //!< Total bytes sent so far
+  bool            m_adaptiveSendSize; //!< Size writes from segment size and tx space
+  uint32_t        m_maxSegmentsPerSend; //!< Largest adaptive write, in segments
+  uint64_t        m_sendCalls;    //!< Number of writes to the sockets
+  uint64_t        m_resumedBytes; //!< Bytes skipped by resumed transfers
+  uint32_t        m_resumedSessions; //!< Number of resumed transfers
+  uint64_t        m_maxBytes;     //!< Default size of a response
+  bool            m_persistent;   //!< Keep connections open between requests
   TypeId          m_tid;          //!< Protocol TypeId
+  std::string     m_congestionControl; //!< Congestion control of the sockets, empty for the default
+  uint32_t        m_initialCwnd;  //!< Initial cwnd of the sockets in segments, 0 for the default
+  uint32_t        m_sndBufSize;   //!< Tx buffer size of the sockets, 0 for the default
+  uint32_t        m_rcvBufSize;   //!< Rx buffer size of the sockets, 0 for the default
+  uint32_t        m_segmentSize;  //!< Segment size of the sockets, 0 for the default
 
   /// Traced Callback: received packets, source address.
   TracedCallback<Ptr<const Packet> > m_txTrace;
   TracedCallback<Ptr<const Packet>, const Address &> m_rxTrace;
+  /// Traced Callback: bytes and packets drained by one HandleRead, source address.
+  TracedCallback<uint32_t, uint32_t, const Address &> m_rxBatchTrace;
+  /// Traced Callback: a response has been fully written.
+  TracedCallback<uint32_t, uint64_t, Time, Time> m_responseTrace;
+  /// Traced Callback: share of the transmit path of a closed connection.
+  TracedCallback<const Address &, uint64_t, double> m_shareTrace;
+
+  TcpTransferStats m_stats;       //!< Statistics of the responses sent
 
 };
 
@@ -0,0 +1,59 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "ns3/object-factory.h"
+#include "ns3/socket.h"
+#include "ns3/tcp-congestion-ops.h"
+#include "ns3/tcp-socket-base.h"
+#include "ns3/uinteger.h"
+#include "tcp-socket-options.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpSocketOptions");
+
+void
+ConfigureTcpSocket (Ptr<Socket> socket, const std::string &congestionControl,
+                    uint32_t initialCwnd, uint32_t sndBufSize,
+                    uint32_t rcvBufSize, uint32_t segmentSize)
+{
+  NS_LOG_FUNCTION (socket << congestionControl << initialCwnd << sndBufSize
+                   << rcvBufSize << segmentSize);
+  if (!congestionControl.empty ())
+    {
+      Ptr<TcpSocketBase> tcp = DynamicCast<TcpSocketBase> (socket);
+      if (!tcp)
+        {
+          NS_FATAL_ERROR ("Congestion control " << congestionControl
+                          << " set on a socket that is not a TcpSocketBase");
+        }
+      std::string name = congestionControl.find ("::") == std::string::npos
+        ? "ns3::" + congestionControl : congestionControl;
+      TypeId tid;
+      if (!TypeId::LookupByNameFailSafe (name, &tid))
+        {
+          NS_FATAL_ERROR ("Unknown congestion control " << congestionControl);
+        }
+      ObjectFactory factory;
+      factory.SetTypeId (tid);
+      tcp->SetCongestionControlAlgorithm (factory.Create<TcpCongestionOps> ());
+    }
+  if (initialCwnd > 0)
+    {
+      socket->SetAttribute ("InitialCwnd", UintegerValue (initialCwnd));
+    }
+  if (sndBufSize > 0)
+    {
+      socket->SetAttribute ("SndBufSize", UintegerValue (sndBufSize));
+    }
+  if (rcvBufSize > 0)
+    {
+      socket->SetAttribute ("RcvBufSize", UintegerValue (rcvBufSize));
+    }
+  if (segmentSize > 0)
+    {
+      socket->SetAttribute ("SegmentSize", UintegerValue (segmentSize));
+    }
+}
+
+} // namespace ns3
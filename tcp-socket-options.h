@@ -0,0 +1,38 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef TCP_SOCKET_OPTIONS_H
+#define TCP_SOCKET_OPTIONS_H
+
+#include "ns3/ptr.h"
+
+#include <stdint.h>
+#include <string>
+
+namespace ns3 {
+
+class Socket;
+
+/**
+ * \ingroup tcpserver
+ * \brief Apply the TCP settings of an application to a new socket.
+ *
+ * Call it before the socket connects or listens: sockets accepted by a
+ * listening socket inherit its settings.  An empty congestion control and
+ * zero values keep the defaults of the node's TcpL4Protocol and of
+ * TcpSocket.
+ *
+ * \param socket a TCP socket
+ * \param congestionControl the TcpCongestionOps TypeId name, e.g.
+ *        "ns3::TcpCubic" or just "TcpCubic"
+ * \param initialCwnd the initial congestion window, in segments
+ * \param sndBufSize the size of the tx buffer, in bytes
+ * \param rcvBufSize the size of the rx buffer, in bytes
+ * \param segmentSize the maximum segment size, in bytes
+ */
+void ConfigureTcpSocket (Ptr<Socket> socket, const std::string &congestionControl,
+                         uint32_t initialCwnd, uint32_t sndBufSize,
+                         uint32_t rcvBufSize, uint32_t segmentSize);
+
+} // namespace ns3
+
+#endif /* TCP_SOCKET_OPTIONS_H */
@@ -0,0 +1,81 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "tcp-token-bucket.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpTokenBucket");
+
+TcpTokenBucket::TcpTokenBucket ()
+  : m_rate (0),
+    m_burst (0),
+    m_tokens (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+TcpTokenBucket::Configure (DataRate rate, uint32_t burst)
+{
+  NS_LOG_FUNCTION (this << rate << burst);
+  m_rate = rate;
+  m_burst = burst;
+  m_tokens = burst;
+  m_lastRefill = Simulator::Now ();
+}
+
+bool
+TcpTokenBucket::IsEnabled (void) const
+{
+  return m_rate.GetBitRate () > 0;
+}
+
+uint32_t
+TcpTokenBucket::GetBurst (void) const
+{
+  return m_burst;
+}
+
+void
+TcpTokenBucket::Refill (void)
+{
+  Time now = Simulator::Now ();
+  m_tokens = std::min<double> (m_burst, m_tokens + (now - m_lastRefill).GetSeconds ()
+                               * m_rate.GetBitRate () / 8.0);
+  m_lastRefill = now;
+}
+
+uint32_t
+TcpTokenBucket::GetAvailable (void)
+{
+  Refill ();
+  return static_cast<uint32_t> (m_tokens);
+}
+
+Time
+TcpTokenBucket::GetWaitTime (uint32_t bytes)
+{
+  Refill ();
+  if (m_tokens >= bytes)
+    {
+      return Time ();
+    }
+  // Round up, so that the tokens are there when the wait is over
+  double seconds = (bytes - m_tokens) * 8.0 / m_rate.GetBitRate ();
+  return NanoSeconds (static_cast<int64_t> (std::ceil (seconds * 1e9)));
+}
+
+void
+TcpTokenBucket::Consume (uint32_t bytes)
+{
+  NS_LOG_FUNCTION (this << bytes);
+  Refill ();
+  m_tokens = std::max (0.0, m_tokens - bytes);
+}
+
+} // namespace ns3
@@ -0,0 +1,71 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef TCP_TOKEN_BUCKET_H
+#define TCP_TOKEN_BUCKET_H
+
+#include "ns3/data-rate.h"
+#include "ns3/nstime.h"
+
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup tcpserver
+ * \brief Token bucket limiting the bytes written to a rate.
+ *
+ * Tokens, one per byte, accrue at the rate up to the burst size. The
+ * bucket starts full. A bucket with a zero rate is disabled and lets
+ * everything through.
+ */
+class TcpTokenBucket
+{
+public:
+  TcpTokenBucket ();
+
+  /**
+   * \brief Set the rate and burst size, and fill the bucket.
+   * \param rate the token rate, zero to disable the bucket
+   * \param burst the bucket depth in bytes
+   */
+  void Configure (DataRate rate, uint32_t burst);
+
+  /**
+   * \return true if the bucket limits anything
+   */
+  bool IsEnabled (void) const;
+  /**
+   * \return the bucket depth in bytes
+   */
+  uint32_t GetBurst (void) const;
+  /**
+   * \return the whole tokens available now
+   */
+  uint32_t GetAvailable (void);
+  /**
+   * \param bytes the bytes to write
+   * \return the time until the bucket holds tokens for bytes, zero if
+   * it does already
+   */
+  Time GetWaitTime (uint32_t bytes);
+  /**
+   * \brief Take the tokens of bytes written.
+   * \param bytes the bytes written
+   */
+  void Consume (uint32_t bytes);
+
+private:
+  /**
+   * \brief Add the tokens accrued since the last refill.
+   */
+  void Refill (void);
+
+  DataRate m_rate;        //!< Token rate
+  uint32_t m_burst;       //!< Bucket depth in bytes
+  double   m_tokens;      //!< Tokens in the bucket
+  Time     m_lastRefill;  //!< Time of the last refill
+};
+
+} // namespace ns3
+
+#endif /* TCP_TOKEN_BUCKET_H */
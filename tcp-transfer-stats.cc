@@ -0,0 +1,118 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "fct-collector.h"
+#include "tcp-transfer-stats.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpTransferStats");
+
+TcpTransferStats::TcpTransferStats ()
+  : m_n (0),
+    m_bytes (0),
+    m_goodputSum (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+TcpTransferStats::Add (uint64_t bytes, Time timeToFirstByte, Time timeToCompletion)
+{
+  NS_LOG_FUNCTION (this << bytes << timeToFirstByte << timeToCompletion);
+  ++m_n;
+  m_bytes += bytes;
+  if (timeToCompletion.IsStrictlyPositive ())
+    {
+      m_goodputSum += bytes * 8.0 / timeToCompletion.GetSeconds ();
+    }
+  m_firstByteSum += timeToFirstByte;
+  m_completionSum += timeToCompletion;
+  if (m_completion.empty ())
+    {
+      m_firstByte.resize (FctCollector::GetNTimeBins (), 0);
+      m_completion.resize (FctCollector::GetNTimeBins (), 0);
+    }
+  ++m_firstByte[FctCollector::GetTimeBin (timeToFirstByte)];
+  ++m_completion[FctCollector::GetTimeBin (timeToCompletion)];
+}
+
+void
+TcpTransferStats::Merge (const TcpTransferStats &other)
+{
+  NS_LOG_FUNCTION (this << &other);
+  m_n += other.m_n;
+  m_bytes += other.m_bytes;
+  m_goodputSum += other.m_goodputSum;
+  m_firstByteSum += other.m_firstByteSum;
+  m_completionSum += other.m_completionSum;
+  if (other.m_completion.empty ())
+    {
+      return;
+    }
+  if (m_completion.empty ())
+    {
+      m_firstByte = other.m_firstByte;
+      m_completion = other.m_completion;
+      return;
+    }
+  for (uint32_t i = 0; i < m_completion.size (); i++)
+    {
+      m_firstByte[i] += other.m_firstByte[i];
+      m_completion[i] += other.m_completion[i];
+    }
+}
+
+uint32_t
+TcpTransferStats::GetN (void) const
+{
+  return m_n;
+}
+
+uint64_t
+TcpTransferStats::GetBytes (void) const
+{
+  return m_bytes;
+}
+
+double
+TcpTransferStats::GetMeanGoodput (void) const
+{
+  return m_n == 0 ? 0 : m_goodputSum / m_n;
+}
+
+Time
+TcpTransferStats::GetMeanTimeToFirstByte (void) const
+{
+  return m_n == 0 ? Time () : m_firstByteSum / static_cast<int64_t> (m_n);
+}
+
+Time
+TcpTransferStats::GetMeanTimeToCompletion (void) const
+{
+  return m_n == 0 ? Time () : m_completionSum / static_cast<int64_t> (m_n);
+}
+
+Time
+TcpTransferStats::GetTimeToFirstBytePercentile (double p) const
+{
+  return Percentile (m_firstByte, p);
+}
+
+Time
+TcpTransferStats::GetTimeToCompletionPercentile (double p) const
+{
+  return Percentile (m_completion, p);
+}
+
+Time
+TcpTransferStats::Percentile (const std::vector<uint64_t> &counts, double p) const
+{
+  if (counts.empty ())
+    {
+      return Time ();
+    }
+  return FctCollector::GetTimePercentile (&counts[0], m_n, p);
+}
+
+} // namespace ns3
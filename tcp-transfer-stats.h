@@ -0,0 +1,101 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef TCP_TRANSFER_STATS_H
+#define TCP_TRANSFER_STATS_H
+
+#include "ns3/nstime.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup tcpserver
+ * \brief Statistics of the completed transfers of an application.
+ *
+ * Keeps totals plus log-scale histograms of the times, with the bins of
+ * FctCollector, so memory does not grow with the number of transfers;
+ * percentiles are the geometric middle of their bin, within 12% of the
+ * exact value.
+ */
+class TcpTransferStats
+{
+public:
+  /**
+   * TracedCallback signature for a completed transfer.
+   *
+   * \param [in] requestId the id of the request
+   * \param [in] bytes the bytes transferred
+   * \param [in] timeToFirstByte time from the request to its first byte
+   * \param [in] timeToCompletion time from the request to its last byte
+   */
+  typedef void (* TransferTracedCallback)
+    (uint32_t requestId, uint64_t bytes, Time timeToFirstByte, Time timeToCompletion);
+
+  TcpTransferStats ();
+
+  /**
+   * \brief Record a completed transfer.
+   * \param bytes the bytes transferred
+   * \param timeToFirstByte time from the request to its first byte
+   * \param timeToCompletion time from the request to its last byte
+   */
+  void Add (uint64_t bytes, Time timeToFirstByte, Time timeToCompletion);
+  /**
+   * \brief Add the transfers recorded by other statistics.
+   * \param other the statistics to add
+   */
+  void Merge (const TcpTransferStats &other);
+
+  /**
+   * \return the number of completed transfers
+   */
+  uint32_t GetN (void) const;
+  /**
+   * \return the bytes of all completed transfers
+   */
+  uint64_t GetBytes (void) const;
+  /**
+   * \return the mean goodput of the completed transfers, in bit/s
+   */
+  double GetMeanGoodput (void) const;
+  /**
+   * \return the mean time to first byte
+   */
+  Time GetMeanTimeToFirstByte (void) const;
+  /**
+   * \return the mean time to completion
+   */
+  Time GetMeanTimeToCompletion (void) const;
+  /**
+   * \param p the percentile, between 0 and 100
+   * \return the p-th percentile of the time to first byte
+   */
+  Time GetTimeToFirstBytePercentile (double p) const;
+  /**
+   * \param p the percentile, between 0 and 100
+   * \return the p-th percentile of the time to completion
+   */
+  Time GetTimeToCompletionPercentile (double p) const;
+
+private:
+  /**
+   * \param counts the bins of a histogram, empty if nothing was recorded
+   * \param p the percentile, between 0 and 100
+   * \return the p-th percentile of the histogram
+   */
+  Time Percentile (const std::vector<uint64_t> &counts, double p) const;
+
+  uint32_t m_n;                        //!< Completed transfers
+  uint64_t m_bytes;                    //!< Bytes of completed transfers
+  double   m_goodputSum;               //!< Sum of per-transfer goodputs
+  Time     m_firstByteSum;             //!< Sum of times to first byte
+  Time     m_completionSum;            //!< Sum of times to completion
+  std::vector<uint64_t> m_firstByte;   //!< Time to first byte histogram, allocated on first use
+  std::vector<uint64_t> m_completion;  //!< Time to completion histogram, allocated on first use
+};
+
+} // namespace ns3
+
+#endif /* TCP_TRANSFER_STATS_H */
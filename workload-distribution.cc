@@ -0,0 +1,138 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "ns3/double.h"
+#include "ns3/integer.h"
+#include "workload-distribution.h"
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WorkloadDistribution");
+
+Ptr<RandomVariableStream>
+CreateDistribution (const std::string &spec)
+{
+  NS_LOG_FUNCTION (spec);
+  if (spec.empty ())
+    {
+      return 0;
+    }
+  std::string::size_type colon = spec.find (':');
+  std::string kind = colon == std::string::npos ? "fixed" : spec.substr (0, colon);
+  std::string arguments = colon == std::string::npos ? spec : spec.substr (colon + 1);
+  if (kind == "cdf")
+    {
+      return LoadEmpiricalCdf (arguments);
+    }
+
+  std::vector<double> values;
+  std::istringstream is (arguments);
+  std::string value;
+  while (std::getline (is, value, ','))
+    {
+      std::istringstream vs (value);
+      double v;
+      if (!(vs >> v))
+        {
+          NS_FATAL_ERROR ("Malformed distribution \"" << spec << "\"");
+        }
+      values.push_back (v);
+    }
+
+  if (kind == "fixed" && values.size () == 1)
+    {
+      Ptr<ConstantRandomVariable> rv = CreateObject<ConstantRandomVariable> ();
+      rv->SetAttribute ("Constant", DoubleValue (values[0]));
+      return rv;
+    }
+  if (kind == "exp" && values.size () == 1)
+    {
+      Ptr<ExponentialRandomVariable> rv = CreateObject<ExponentialRandomVariable> ();
+      rv->SetAttribute ("Mean", DoubleValue (values[0]));
+      return rv;
+    }
+  if (kind == "pareto" && (values.size () == 2 || values.size () == 3))
+    {
+      double mean = values[0];
+      double shape = values[1];
+      if (shape <= 1)
+        {
+          NS_FATAL_ERROR ("Pareto shape of \"" << spec << "\" must exceed 1 for a finite mean");
+        }
+      Ptr<ParetoRandomVariable> rv = CreateObject<ParetoRandomVariable> ();
+      rv->SetAttribute ("Scale", DoubleValue (mean * (shape - 1) / shape));
+      rv->SetAttribute ("Shape", DoubleValue (shape));
+      if (values.size () == 3)
+        {
+          rv->SetAttribute ("Bound", DoubleValue (values[2]));
+        }
+      return rv;
+    }
+  if (kind == "uniform" && values.size () == 2)
+    {
+      Ptr<UniformRandomVariable> rv = CreateObject<UniformRandomVariable> ();
+      rv->SetAttribute ("Min", DoubleValue (values[0]));
+      rv->SetAttribute ("Max", DoubleValue (values[1]));
+      return rv;
+    }
+  if (kind == "zipf" && values.size () == 2)
+    {
+      Ptr<ZipfRandomVariable> rv = CreateObject<ZipfRandomVariable> ();
+      rv->SetAttribute ("N", IntegerValue (static_cast<int64_t> (values[0])));
+      rv->SetAttribute ("Alpha", DoubleValue (values[1]));
+      return rv;
+    }
+  NS_FATAL_ERROR ("Unknown distribution \"" << spec << "\", expected fixed:VALUE, "
+                  "exp:MEAN, pareto:MEAN,SHAPE[,BOUND], uniform:MIN,MAX, zipf:N,ALPHA "
+                  "or cdf:FILE");
+  return 0;
+}
+
+Ptr<EmpiricalRandomVariable>
+LoadEmpiricalCdf (const std::string &fileName)
+{
+  NS_LOG_FUNCTION (fileName);
+  std::ifstream file (fileName.c_str ());
+  if (!file)
+    {
+      NS_FATAL_ERROR ("Cannot open CDF file " << fileName);
+    }
+  Ptr<EmpiricalRandomVariable> rv = CreateObject<EmpiricalRandomVariable> ();
+  double lastValue = 0;
+  double lastProbability = 0;
+  uint32_t points = 0;
+  std::string line;
+  while (std::getline (file, line))
+    {
+      std::string::size_type start = line.find_first_not_of (" \t\r\n");
+      if (start == std::string::npos || line[start] == '#')
+        {
+          continue;
+        }
+      std::istringstream is (line.substr (start));
+      double value;
+      double probability;
+      if (!(is >> value >> probability)
+          || probability < lastProbability || probability > 1
+          || (points > 0 && value < lastValue))
+        {
+          NS_FATAL_ERROR ("Malformed CDF point \"" << line << "\" in " << fileName);
+        }
+      rv->CDF (value, probability);
+      lastValue = value;
+      lastProbability = probability;
+      ++points;
+    }
+  if (points == 0 || lastProbability != 1)
+    {
+      NS_FATAL_ERROR ("The CDF of " << fileName << " does not reach 1");
+    }
+  NS_LOG_INFO ("Read " << points << " CDF points from " << fileName);
+  return rv;
+}
+
+} // namespace ns3
@@ -0,0 +1,49 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef WORKLOAD_DISTRIBUTION_H
+#define WORKLOAD_DISTRIBUTION_H
+
+#include "ns3/ptr.h"
+#include "ns3/random-variable-stream.h"
+
+#include <string>
+
+namespace ns3 {
+
+/**
+ * \brief Create a random variable from a short text form.
+ *
+ * The forms are:
+ *
+ *     fixed:VALUE            (or just VALUE)
+ *     exp:MEAN
+ *     pareto:MEAN,SHAPE[,BOUND]
+ *     uniform:MIN,MAX
+ *     zipf:N,ALPHA           (integers 1 to N, 1 the most likely)
+ *     cdf:FILE
+ *
+ * e.g. "exp:0.05" for Poisson arrivals 50 ms apart on average, or
+ * "pareto:15360,1.2" for heavy-tailed object sizes of 15 KiB on average.
+ * The file of an empirical CDF is read with LoadEmpiricalCdf.
+ *
+ * \param spec the distribution
+ * \return the random variable, or 0 if spec is empty
+ */
+Ptr<RandomVariableStream> CreateDistribution (const std::string &spec);
+
+/**
+ * \brief Read an empirical distribution from a file.
+ *
+ * Each line holds a value and the probability of drawing at most that
+ * value, e.g. "15360 0.8". Values and probabilities increase from line
+ * to line and the last probability is 1. Blank lines and lines starting
+ * with '#' are ignored.
+ *
+ * \param fileName the file
+ * \return the random variable
+ */
+Ptr<EmpiricalRandomVariable> LoadEmpiricalCdf (const std::string &fileName);
+
+} // namespace ns3
+
+#endif /* WORKLOAD_DISTRIBUTION_H */